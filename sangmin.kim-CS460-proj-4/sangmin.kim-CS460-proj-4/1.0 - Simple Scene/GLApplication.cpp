@@ -23,6 +23,7 @@
 #include <iostream>
 
 #include "Camera.hpp"
+#include "ClothWorld.h"
 #include "Graphic.h"
 #include "Shader.h"
 
@@ -179,6 +180,43 @@ int main()
         	ImGui::TreePop();
         }
 
+        if(ImGui::TreeNode("ClothMaterial"))
+        {
+            std::vector<ClothMaterial>& materials = graphic->physicsSimulation->GetMaterials();
+            const int materialsSize = static_cast<int>(materials.size());
+
+            for (int i = 0; i < materialsSize; ++i)
+            {
+                ImGui::PushID(i);
+                ImGui::Text("Region %d", i);
+                ImGui::SliderFloat("Mass", &materials[i].mass, 0.001f, 1.f);
+                ImGui::SliderFloat("SpringConstant", &materials[i].springConstant, 0.f, 10.f);
+                ImGui::SliderFloat("DampingConstant", &materials[i].dampingConstant, 0.f, 1.f);
+                ImGui::SliderFloat("RestLength", &materials[i].restLength, 0.001f, 0.5f);
+                ImGui::PopID();
+            }
+
+            //regions are assigned when the cloth is built
+            ImGui::SliderInt("Regions (on reset)", &graphic->physicsSimulation->materialRegionCount, 1, 8);
+            ImGui::TreePop();
+        }
+
+        ImGui::Checkbox("Sleep settled cloth", &graphic->physicsSimulation->allowSleeping);
+        ImGui::Text("Awake tiles : %u / %u", graphic->physicsSimulation->GetAwakeTileCount(),
+            graphic->physicsSimulation->GetTileCount());
+
+        ImGui::Checkbox("Multi resolution (on reset)", &graphic->physicsSimulation->multiResolution);
+        ImGui::SliderInt("Refinement (on reset)", &graphic->physicsSimulation->refinement, 2, 6);
+        ImGui::Checkbox("Strain limiting", &graphic->physicsSimulation->strainLimiting);
+        ImGui::SliderFloat("Max stretch", &graphic->physicsSimulation->maxStretch, 0.f, 1.f);
+        ImGui::Checkbox("Adaptive step", &graphic->physicsSimulation->adaptiveStep);
+        ImGui::Text("Substeps : %d, rollbacks : %u", graphic->physicsSimulation->lastSubstepCount,
+            graphic->physicsSimulation->rollbackCount);
+
+        ImGui::Checkbox("Cloth world", &graphic->showClothWorld);
+        ImGui::Text("Cloth world : %u cloths, %u masses", graphic->clothWorld->GetClothCount(),
+            graphic->clothWorld->GetMassCount());
+
         if(ImGui::Button("Reset"))
         {
             graphic->ReInitSimulation();
@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include "AnimationModel.h"
+#include "AnimationSkeleton.h"
 #include <assimp/scene.h>
 #include <GL/glew.h>
 #include <glm/gtx/transform.hpp>
@@ -16,6 +17,7 @@
 #include "Interpolation.h"
 #include "Material.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 #include "Quaternion.h"
 
@@ -157,9 +159,9 @@ namespace AnimatingFunctions
 
 					std::string fullPath = filename + "/" + p;
 					std::string filePath = "../Models/" + vec[vec.size() - 1];
-					model->datas->materials[index].pDiffuse = new Texture(GL_TEXTURE_2D, filePath);
+					model->datas->materials[index].pDiffuse = TextureCache::Get().Acquire(filePath);
 
-					if(!model->datas->materials[index].pDiffuse->Load())
+					if(!model->datas->materials[index].pDiffuse)
 					{
 						std::cout << "Failed to Load diffuse texture" << std::endl;
 						model->isTextured = AnimationModel::TextureInfos::NONE;
@@ -197,9 +199,9 @@ namespace AnimatingFunctions
 
 					std::string fullPath = filename + "/" + p;
 
-					model->datas->materials[index].pSpecular = new Texture(GL_TEXTURE_2D, vec[vec.size() - 1]);
+					model->datas->materials[index].pSpecular = TextureCache::Get().Acquire(vec[vec.size() - 1]);
 
-					if (!model->datas->materials[index].pSpecular->Load())
+					if (!model->datas->materials[index].pSpecular)
 					{
 						std::cout << "Failed to Load Specular texture" << std::endl;
 						//exit(0);
@@ -302,6 +304,32 @@ namespace AnimatingFunctions
 		{
 			transforms.resize(model->datas->boneInfos.size());
 
+			GetBoneTransforms(transforms.data(), timeInSeconds, scene, model, animationIndex);
+		}
+
+		/*
+		 * Writes only into transforms (boneInfos.size() matrices), model is read only,
+		 * so several instances can be evaluated at the same time on worker threads.
+		 */
+		void GetBoneTransforms(glm::mat4* transforms, float timeInSeconds, const aiScene* scene, const AnimationModel* model, unsigned animationIndex)
+		{
+			//scene released after CompressAnimations, sample compressed clips through skeleton
+			if (scene == nullptr)
+			{
+				thread_local LocalPose pose;
+				thread_local std::vector<glm::mat4> globals;
+
+				if (animationIndex >= model->skeleton->GetClipCount())
+					animationIndex = 0;
+
+				model->skeleton->SampleClip(animationIndex, timeInSeconds, pose);
+				model->skeleton->BuildTransforms(pose, model->datas->boneInfos, globals, transforms);
+				return;
+			}
+
+			if (animationIndex >= scene->mNumAnimations)
+				animationIndex = 0;
+
 			const aiAnimation* animation = scene->mAnimations[animationIndex];
 			const glm::mat4 identityMat = glm::mat4(1.f);
 
@@ -309,15 +337,10 @@ namespace AnimatingFunctions
 			const float timeInTicks = timeInSeconds * ticksPerSecond;
 			const float animationTimeTicks = fmod(timeInTicks, static_cast<float>(animation->mDuration));
 
-			ReadNodeHierarchy(scene->mRootNode, identityMat, animationTimeTicks, scene, model, animationIndex);
-
-			const uint size = model->datas->boneInfos.size();
-
-			for (uint i = 0; i < size; ++i)
-				transforms[i] = model->datas->boneInfos[i].finalTransform;
+			ReadNodeHierarchy(scene->mRootNode, identityMat, animationTimeTicks, scene, model, animationIndex, transforms);
 		}
 
-		void ReadNodeHierarchy(const aiNode* node, const glm::mat4& parentTransform, float animationTimeTicks, const aiScene* scene, AnimationModel* model, int animationIndex)
+		void ReadNodeHierarchy(const aiNode* node, const glm::mat4& parentTransform, float animationTimeTicks, const aiScene* scene, const AnimationModel* model, int animationIndex, glm::mat4* transforms)
 		{
 			std::string nodeName(node->mName.data);
 
@@ -349,14 +372,15 @@ namespace AnimatingFunctions
 			const glm::mat4 globalTransform = parentTransform * nodeTransform;
 
 			//Means find
-			if (model->datas->boneName2IndexMap.find(nodeName) != model->datas->boneName2IndexMap.end())
+			const auto boneIt = model->datas->boneName2IndexMap.find(nodeName);
+			if (boneIt != model->datas->boneName2IndexMap.end())
 			{
-				const uint boneIndex = model->datas->boneName2IndexMap[nodeName];
-				model->datas->boneInfos[boneIndex].finalTransform = globalTransform * model->datas->boneInfos[boneIndex].offsetMat;
+				const uint boneIndex = boneIt->second;
+				transforms[boneIndex] = globalTransform * model->datas->boneInfos[boneIndex].offsetMat;
 			}
 
 			for (uint i = 0; i < node->mNumChildren; ++i)
-				ReadNodeHierarchy(node->mChildren[i], globalTransform, animationTimeTicks, scene, model, animationIndex);
+				ReadNodeHierarchy(node->mChildren[i], globalTransform, animationTimeTicks, scene, model, animationIndex, transforms);
 		}
 
 		aiNodeAnim* FindNodeAnimation(const aiAnimation* pAnimation, const std::string& nodeName)
@@ -48,7 +48,8 @@ namespace AnimatingFunctions
 	namespace AnimationMatrix
 	{
 		void GetBoneTransforms(std::vector<glm::mat4>& transforms, float timeInSeconds, const aiScene* scene, AnimationModel* model, unsigned animationIndex);
-		void ReadNodeHierarchy(const aiNode* node, const glm::mat4& parentTransform, float animationTimeTicks, const aiScene* scene, AnimationModel* model, int animationIndex);
+		void GetBoneTransforms(glm::mat4* transforms, float timeInSeconds, const aiScene* scene, const AnimationModel* model, unsigned animationIndex);
+		void ReadNodeHierarchy(const aiNode* node, const glm::mat4& parentTransform, float animationTimeTicks, const aiScene* scene, const AnimationModel* model, int animationIndex, glm::mat4* transforms);
 		aiNodeAnim* FindNodeAnimation(const aiAnimation* pAnimation, const std::string& nodeName);
 	}
 }
@@ -0,0 +1,151 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for blend clips of one animating instance.
+ */
+
+#include "AnimationBlender.h"
+
+#include "AnimationModel.h"
+#include "PoseBlending.h"
+
+AnimationBlender::AnimationBlender(AnimationModel* model_)
+{
+	model = model_;
+	Play(0);
+}
+
+AnimationBlender::~AnimationBlender()
+{
+}
+
+void AnimationBlender::Play(unsigned animationIndex)
+{
+	SetClips({ BlendClip{ animationIndex, 1.f } });
+}
+
+void AnimationBlender::SetClips(const std::vector<BlendClip>& clips)
+{
+	currentClips = clips;
+	previousClips.clear();
+	fadeDuration = 0.f;
+	fadeTime = 0.f;
+}
+
+void AnimationBlender::CrossFade(unsigned animationIndex, float duration)
+{
+	CrossFade({ BlendClip{ animationIndex, 1.f } }, duration);
+}
+
+/*
+ * Fading out set is replaced by current set.
+ * If a fade is already running, it snaps to its target first.
+ */
+void AnimationBlender::CrossFade(const std::vector<BlendClip>& clips, float duration)
+{
+	if (duration <= 0.f)
+	{
+		SetClips(clips);
+		return;
+	}
+
+	previousClips = currentClips;
+	currentClips = clips;
+	fadeDuration = duration;
+	fadeTime = 0.f;
+}
+
+void AnimationBlender::AddAdditiveLayer(unsigned animationIndex, float weight)
+{
+	AdditiveLayer layer;
+	layer.animationIndex = animationIndex;
+	layer.weight = weight;
+	model->skeleton->SampleClip(animationIndex, 0.f, layer.reference);
+
+	additiveLayers.push_back(layer);
+}
+
+void AnimationBlender::SetAdditiveWeight(unsigned layerIndex, float weight)
+{
+	additiveLayers[layerIndex].weight = weight;
+}
+
+void AnimationBlender::ClearAdditiveLayers()
+{
+	additiveLayers.clear();
+}
+
+void AnimationBlender::Update(float dt)
+{
+	if (!IsFading())
+		return;
+
+	fadeTime += dt;
+
+	if (fadeTime >= fadeDuration)
+	{
+		previousClips.clear();
+		fadeDuration = 0.f;
+		fadeTime = 0.f;
+	}
+}
+
+void AnimationBlender::Evaluate(float animationT, glm::mat4* transforms)
+{
+	const AnimationSkeleton* skeleton = model->skeleton;
+
+	EvaluateClips(currentClips, animationT, currentPose);
+
+	if (IsFading())
+	{
+		EvaluateClips(previousClips, animationT, previousPose);
+
+		const float factor = fadeTime / fadeDuration;
+		PoseBlending::BlendPose(previousPose, currentPose, factor, currentPose, true);
+	}
+
+	for (AdditiveLayer& layer : additiveLayers)
+	{
+		if (layer.weight <= 0.f)
+			continue;
+
+		skeleton->SampleClip(layer.animationIndex, animationT, samplePose);
+		PoseBlending::AddPose(currentPose, samplePose, layer.reference, layer.weight);
+	}
+
+	skeleton->BuildTransforms(currentPose, model->datas->boneInfos, globals, transforms);
+}
+
+bool AnimationBlender::IsFading() const
+{
+	return !previousClips.empty() && fadeDuration > 0.f;
+}
+
+/*
+ * Incremental weighted blend : each clip is blended in with weight / (sum of weights so far).
+ */
+void AnimationBlender::EvaluateClips(const std::vector<BlendClip>& clips, float animationT, LocalPose& out)
+{
+	const AnimationSkeleton* skeleton = model->skeleton;
+
+	if (clips.empty())
+	{
+		out = skeleton->GetBindPose();
+		return;
+	}
+
+	skeleton->SampleClip(clips[0].animationIndex, animationT, out);
+	float totalWeight = clips[0].weight;
+
+	const size_t clipsSize = clips.size();
+	for (size_t i = 1; i < clipsSize; ++i)
+	{
+		if (clips[i].weight <= 0.f)
+			continue;
+
+		totalWeight += clips[i].weight;
+
+		skeleton->SampleClip(clips[i].animationIndex, animationT, samplePose);
+		PoseBlending::BlendPose(out, samplePose, clips[i].weight / totalWeight, out);
+	}
+}
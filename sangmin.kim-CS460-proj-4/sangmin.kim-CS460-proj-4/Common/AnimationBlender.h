@@ -0,0 +1,68 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for blend clips of one animating instance.
+ *                Weighted blend of several clips, timed cross fade to new clips,
+ *                and additive layers on top. Evaluated on AnimationSkeleton.
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+#include "AnimationSkeleton.h"
+
+class AnimationModel;
+
+struct BlendClip
+{
+	unsigned animationIndex;
+	float weight;
+};
+
+class AnimationBlender
+{
+public:
+	AnimationBlender(AnimationModel* model_);
+	~AnimationBlender();
+
+	void Play(unsigned animationIndex);
+	void SetClips(const std::vector<BlendClip>& clips);
+	void CrossFade(unsigned animationIndex, float duration);
+	void CrossFade(const std::vector<BlendClip>& clips, float duration);
+
+	//reference pose of the layer is its first frame
+	void AddAdditiveLayer(unsigned animationIndex, float weight);
+	void SetAdditiveWeight(unsigned layerIndex, float weight);
+	void ClearAdditiveLayers();
+
+	void Update(float dt);
+	void Evaluate(float animationT, glm::mat4* transforms);
+
+	bool IsFading() const;
+
+private:
+	struct AdditiveLayer
+	{
+		unsigned animationIndex;
+		float weight;
+		LocalPose reference;
+	};
+
+	void EvaluateClips(const std::vector<BlendClip>& clips, float animationT, LocalPose& out);
+
+	AnimationModel* model;
+	std::vector<BlendClip> currentClips;
+	std::vector<BlendClip> previousClips;
+	std::vector<AdditiveLayer> additiveLayers;
+
+	float fadeDuration = 0.f;
+	float fadeTime = 0.f;
+
+	//scratch, kept between frames
+	LocalPose samplePose;
+	LocalPose currentPose;
+	LocalPose previousPose;
+	std::vector<glm::mat4> globals;
+};
@@ -7,17 +7,21 @@
 
 #include "AnimationModel.h"
 
+#include <iostream>
 #include <assimp/scene.h>
 #include <GL/glew.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "AnimatingFunctions.h"
+#include "AnimationSkeleton.h"
 #include "Camera.hpp"
 #include "Shader.h"
 #include "assimp/postprocess.h"
 
 #include "Texture.h"
 #include "AnimationModelDatas.h"
+#include "BoneStorageManager.h"
+#include "ModelCache.h"
 
 #define ASSIMP_LOAD_FLAGS (aiProcess_Triangulate | aiProcess_GenSmoothNormals |  aiProcess_JoinIdenticalVertices )
 
@@ -28,12 +32,19 @@
  *
  * AnimationModelDatas
  * Store all infos about model (positions, normals, textureCoords, index)
- * Also, I use Shader Storage Buffer Object to store boneIndexes, weights, BoneStartIndex, BoneEndIndex, so it stores index of ssbo.
+ * Bone ids / weights are reduced to the strongest maxBoneInfluences (up to 8) per vertex,
+ * and passed as vertex attributes.
  *
  * After that, Reserve VectorSpace,
  * Read positions / texCoords / normals hierarchical, Also, Find & load texture files.
+ *
+ * If binary cache of the file is up to date (ModelCache), all of above is skipped
+ * and buffers are uploaded from the mapped cache. Otherwise the imported result
+ * (with compressed clips) is written to the cache for next launch.
+ *
+ * With deferLoading, AssetLoader runs LoadData on worker thread and UploadData on GL thread later.
  */
-AnimationModel::AnimationModel(Shader* shaderVal, std::string _filePath)
+AnimationModel::AnimationModel(Shader* shaderVal, std::string _filePath, int maxBoneInfluences, bool deferLoading)
 {
 	assert(shaderVal != nullptr);
 	shader = shaderVal;
@@ -47,22 +58,77 @@ AnimationModel::AnimationModel(Shader* shaderVal, std::string _filePath)
 	startTime = std::chrono::system_clock::now();
 	filePath = _filePath;
 	importer = new Importer();
-	
+	scene = nullptr;
+	skeleton = nullptr;
+
+	datas = new AnimationModelDatas();
+	datas->maxBoneInfluences = maxBoneInfluences;
+
+	if (deferLoading)
+		return;
+
+	if (LoadData())
+		UploadData();
+}
+
+/*
+ * CPU part of loading, no GL calls.
+ */
+bool AnimationModel::LoadData()
+{
+	if (ModelCache::Load(filePath, this))
+		return true;
+
 	scene = importer->ReadFile(filePath.c_str(),
 		ASSIMP_LOAD_FLAGS);
 
-	datas = new AnimationModelDatas();
+	if (scene == nullptr)
+	{
+		std::cout << "Failed to load model : " << filePath << std::endl;
+		return false;
+	}
 
 	datas->ReserveSpace(scene);
 	AnimatingFunctions::MeshInitializing::InitAllMeshes(this);
-	datas->PopulateBuffers(vao);
+	datas->PackBones();
 	AnimatingFunctions::MaterialInitializing::InitMaterials(filePath, this);
+
+	skeleton = new AnimationSkeleton(scene, datas);
+
+	CompressAnimations(ClipCompressionSettings());
+	ModelCache::Save(filePath, this);
+
+	return true;
+}
+
+/*
+ * GL part of loading, vertex buffers and decoded textures.
+ */
+void AnimationModel::UploadData()
+{
+	datas->UploadPending(vao);
+
+	for (Material& material : datas->materials)
+	{
+		if (material.pDiffuse)
+			material.pDiffuse->Upload();
+		if (material.pSpecular)
+			material.pSpecular->Upload();
+	}
+
+	uploaded = true;
+}
+
+bool AnimationModel::IsUploaded() const
+{
+	return uploaded;
 }
 
 AnimationModel::~AnimationModel()
 {
 	delete importer;
 	delete datas;
+	delete skeleton;
 }
 
 
@@ -84,6 +150,25 @@ void AnimationModel::CheckBuffers()
 void AnimationModel::Draw(
 	const glm::mat4& objMat, const glm::mat4& projViewMat, float animationT, int transformsOffset,
 	unsigned animationIndex)
+{
+	std::vector<glm::mat4> transforms;
+
+	if(animationIndex >= skeleton->GetClipCount())
+		animationIndex = 0;
+
+	AnimatingFunctions::AnimationMatrix::GetBoneTransforms(transforms, animationT, scene, this, animationIndex);
+
+	DrawPose(objMat, projViewMat, animationT, transformsOffset, transforms.data(),
+		static_cast<unsigned>(transforms.size()));
+}
+
+/*
+ * Draw with already evaluated bone transforms (PoseEvaluator),
+ * only GL calls happen here.
+ */
+void AnimationModel::DrawPose(
+	const glm::mat4& objMat, const glm::mat4& projViewMat, float animationT, int transformsOffset,
+	const glm::mat4* transforms, unsigned transformsCount)
 {
 	assert(shader != nullptr);
 
@@ -93,16 +178,7 @@ void AnimationModel::Draw(
 	glm::mat4 matrix = projViewMat * objMat;
 	shader->SendUniformMatGLM("gWVP", matrix);
 
-	std::vector<glm::mat4> transforms;
-
-	if(animationIndex >= scene->mNumAnimations)
-		animationIndex = 0;
-
-	AnimatingFunctions::AnimationMatrix::GetBoneTransforms(transforms, animationT, scene, this, animationIndex);
-
-	const uint size = transforms.size();
-
-	for (uint i = 0; i < size; ++i)
+	for (uint i = 0; i < transformsCount; ++i)
 	{
 		std::string path = "gBones[";
 		path += std::to_string(i);
@@ -116,6 +192,8 @@ void AnimationModel::Draw(
 
 	shader->SendUniformInt("transformIndex", transformsOffset);
 
+	shader->SendUniformInt("influenceCount", datas->storage->GetInfluenceCount());
+
 	shader->SendUniformFloat("timeTicks", animationT);
 
 	const unsigned meshesSize = datas->meshes.size();
@@ -148,14 +226,38 @@ aiNode* AnimationModel::GetRootNode()
 	return rootNode;
 }
 
-const aiScene* AnimationModel::GetScene()
+const aiScene* AnimationModel::GetScene() const
 {
 	return scene;
 }
 
+unsigned AnimationModel::GetBoneCount() const
+{
+	return static_cast<unsigned>(datas->boneInfos.size());
+}
+
 void AnimationModel::PopulateTransforms(std::vector<glm::mat4>& transforms)
 {
 	datas->PopulateTransforms(vao, transforms);
 }
 
 
+
+/*
+ * Replace raw assimp keys with CompressedClip for every clip.
+ * If releaseScene, aiScene is freed (meshes / materials were already copied into datas),
+ * and all sampling goes through skeleton from now on.
+ */
+void AnimationModel::CompressAnimations(const ClipCompressionSettings& settings, bool releaseScene)
+{
+	skeleton->Compress(settings);
+
+	std::cout << "Animation compression (" << filePath << ") : "
+		<< skeleton->GetRawMemory() << " bytes -> " << skeleton->GetCompressedMemory() << " bytes" << std::endl;
+
+	if (releaseScene && scene != nullptr)
+	{
+		importer->FreeScene();
+		scene = nullptr;
+	}
+}
@@ -11,8 +11,10 @@
 #include <assimp/Importer.hpp>
 #include "AnimationStructure.hpp"
 #include "AnimationModelDatas.h"
+#include "CompressedClip.h"
 
 struct aiNode;
+class AnimationSkeleton;
 class Camera;
 class Shader;
 
@@ -27,18 +29,29 @@ public:
 		TEXTURED
 	};
 
-	AnimationModel(Shader* shaderVal, std::string _filePath);
+	//deferLoading : only GL objects are created, caller runs LoadData (any thread) then UploadData (GL thread).
+	AnimationModel(Shader* shaderVal, std::string _filePath,
+		int maxBoneInfluences = DEFAULT_NUM_BONES_PER_VERTEX, bool deferLoading = false);
 	~AnimationModel();
+
+	bool LoadData();
+	void UploadData();
+	bool IsUploaded() const;
 	
 	void Select();
 	void CheckBuffers();
 	void Draw(const glm::mat4& objMat, const glm::mat4& projViewMat,
 		float animationT, int transformsOffset, unsigned animationIndex);
+	void DrawPose(const glm::mat4& objMat, const glm::mat4& projViewMat,
+		float animationT, int transformsOffset, const glm::mat4* transforms, unsigned transformsCount);
 	aiNode* GetRootNode();
-	const aiScene* GetScene();
+	const aiScene* GetScene() const;
+	unsigned GetBoneCount() const;
 	void PopulateTransforms(std::vector<glm::mat4>& transforms);
+	void CompressAnimations(const ClipCompressionSettings& settings, bool releaseScene = true);
 	
 	AnimationModelDatas* datas;
+	AnimationSkeleton* skeleton;
 	std::chrono::system_clock::time_point startTime;
 
 	TextureInfos isTextured = TextureInfos::NONE;
@@ -51,6 +64,7 @@ private:
 	Shader* shader;
 
 	unsigned vao;
+	bool uploaded = false;
 	int numVertices, numIndices;
 	std::string filePath;
 
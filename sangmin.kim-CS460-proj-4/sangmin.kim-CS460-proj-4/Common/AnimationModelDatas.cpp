@@ -7,18 +7,19 @@
 
 #include "AnimationModelDatas.h"
 
+#include <cstring>
+#include <iostream>
 #include <assimp/scene.h>
 #include <GL/glew.h>
+#include <glm/gtc/packing.hpp>
 #include "Buffer.hpp"
 
 #include "BoneStorageManager.h"
+#include "MappedFile.h"
+#include "VertexCacheOptimizer.h"
 
 AnimationModelDatas::AnimationModelDatas()
 {
-	glGenBuffers(1, &ssboBones);
-	glGenBuffers(1, &ssboWeights);
-	glGenBuffers(1, &ssboIndexStarts);
-	glGenBuffers(1, &ssboIndexEnds);
 	glGenBuffers(1, &ssboTransforms);
 }
 
@@ -28,13 +29,13 @@ AnimationModelDatas::~AnimationModelDatas()
 	delete texBuffer;
 	delete normalBuffer;
 	delete indexBuffer;
+	delete boneIdBuffer;
+	delete boneWeightBuffer;
+	delete vertexBuffer;
 
 	delete storage;
+	delete pendingMapping;
 
-	glDeleteBuffers(1, &ssboBones);
-	glDeleteBuffers(1, &ssboWeights);
-	glDeleteBuffers(1, &ssboIndexStarts);
-	glDeleteBuffers(1, &ssboIndexEnds);
 	glDeleteBuffers(1, &ssboTransforms);
 }
 
@@ -70,34 +71,79 @@ void AnimationModelDatas::ReserveSpace(const aiScene* scene)
 }
 
 void AnimationModelDatas::PopulateBuffers(unsigned vao)
+{
+	PackBones();
+	UploadPending(vao);
+}
+
+void AnimationModelDatas::PackBones()
+{
+	storage = new BoneStorageManager(bones, maxBoneInfluences);
+
+	//16-slot import data is not needed after packing.
+	std::vector<VertexBoneData>().swap(bones);
+
+	if (optimizeVertexCache)
+		OptimizeIndices();
+
+	pendingStreams.positions = positions.data();
+	pendingStreams.texCoords = texCoords.data();
+	pendingStreams.normals = normals.data();
+	pendingStreams.boneIds = storage->boneIds.data();
+	pendingStreams.boneWeights = storage->weights.data();
+	pendingStreams.indices = indices.data();
+}
+
+void AnimationModelDatas::UploadPending(unsigned vao)
+{
+	UploadBuffers(vao, pendingStreams.positions, pendingStreams.texCoords, pendingStreams.normals,
+		pendingStreams.boneIds, pendingStreams.boneWeights, pendingStreams.indices);
+
+	pendingStreams = VertexStreams();
+	delete pendingMapping;
+	pendingMapping = nullptr;
+}
+
+void AnimationModelDatas::UploadBuffers(unsigned vao, const glm::vec3* positionData, const glm::vec2* texCoordData,
+	const glm::vec3* normalData, const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData,
+	const unsigned* indexData)
 {
 	glBindVertexArray(vao);
 
-	posBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * positions.size(), GL_STATIC_DRAW,
-		positions.data());
+	if (interleavedVertices)
+	{
+		UploadInterleaved(positionData, texCoordData, normalData, boneIdData, boneWeightData);
+
+		indexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * numIndices,
+			GL_STATIC_DRAW, indexData);
+
+		glBindVertexArray(0);
+		return;
+	}
+
+	posBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * numVertices, GL_STATIC_DRAW,
+		positionData);
 	posBuffer->Bind();
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
 	
 
-	texBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec2) * texCoords.size(), GL_STATIC_DRAW,
-		texCoords.data());
+	texBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec2) * numVertices, GL_STATIC_DRAW,
+		texCoordData);
 	texBuffer->Bind();
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLvoid*)0);
 
-	normalBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(), GL_STATIC_DRAW,
-		normals.data());
+	normalBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * numVertices, GL_STATIC_DRAW,
+		normalData);
 	normalBuffer->Bind();
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
 
-	storage = new BoneStorageManager(bones);
+	PopulateBoneAttributes(boneIdData, boneWeightData);
 
-	PopulateShaderStorage();
-
-	indexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * indices.size(),
-		GL_STATIC_DRAW, indices.data());
+	indexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * numIndices,
+		GL_STATIC_DRAW, indexData);
 
 	glBindVertexArray(0);
 }
@@ -117,34 +163,120 @@ void AnimationModelDatas::PopulateTransforms(unsigned vao, std::vector<glm::mat4
 	glBindVertexArray(0);
 }
 
-void AnimationModelDatas::PopulateShaderStorage()
+/*
+ * Bone ids / weights as per-vertex attributes.
+ * Each group holds 4 influences : ids at location 3 + 2 * group, weights at location 4 + 2 * group.
+ */
+void AnimationModelDatas::PopulateBoneAttributes(const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData)
 {
-	const size_t bonesSize = storage->bones.size();
-	const size_t weightsSize = storage->weights.size();
-	const size_t startIndexSize = storage->indexStarts.size();
-	const size_t endIndexSize = storage->indexEnds.size();
-
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboBones);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * bonesSize,
-		storage->bones.data(), GL_STATIC_DRAW);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboBones);
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	const int groupCount = storage->GetGroupCount();
+	const GLsizei stride = static_cast<GLsizei>(sizeof(glm::u16vec4) * groupCount);
+	const size_t groupTotal = static_cast<size_t>(numVertices) * groupCount;
 
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboWeights);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * weightsSize,
-		storage->weights.data(), GL_STATIC_DRAW);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssboWeights);
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	boneIdBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::u16vec4) * groupTotal, GL_STATIC_DRAW,
+		boneIdData);
+	boneIdBuffer->Bind();
+	for (int group = 0; group < groupCount; ++group)
+	{
+		const GLuint location = 3 + 2 * group;
+		glEnableVertexAttribArray(location);
+		glVertexAttribIPointer(location, 4, GL_UNSIGNED_SHORT, stride,
+			(GLvoid*)(sizeof(glm::u16vec4) * group));
+	}
 
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboIndexStarts);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * startIndexSize,
-		storage->indexStarts.data(), GL_STATIC_DRAW);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboIndexStarts);
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	boneWeightBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::u16vec4) * groupTotal, GL_STATIC_DRAW,
+		boneWeightData);
+	boneWeightBuffer->Bind();
+	for (int group = 0; group < groupCount; ++group)
+	{
+		const GLuint location = 4 + 2 * group;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+			(GLvoid*)(sizeof(glm::u16vec4) * group));
+	}
+}
 
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboIndexEnds);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * endIndexSize,
-		storage->indexEnds.data(), GL_STATIC_DRAW);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, ssboIndexEnds);
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+/*
+ * Indices of each mesh are local to its BaseVertex, so every mesh is optimized on its own.
+ */
+void AnimationModelDatas::OptimizeIndices()
+{
+	float missesBefore = 0.f, missesAfter = 0.f;
+	const size_t meshesSize = meshes.size();
+
+	for (size_t i = 0; i < meshesSize; ++i)
+	{
+		const BasicMeshEntry& mesh = meshes[i];
+		const unsigned vertexEnd = i + 1 < meshesSize ? meshes[i + 1].BaseVertex : static_cast<unsigned>(numVertices);
+		const unsigned vertexCount = vertexEnd - mesh.BaseVertex;
+		unsigned* meshIndices = indices.data() + mesh.BaseIndex;
+
+		missesBefore += VertexCacheOptimizer::CalculateACMR(meshIndices, mesh.NumIndices, vertexCount) * (mesh.NumIndices / 3);
+		VertexCacheOptimizer::Optimize(meshIndices, mesh.NumIndices, vertexCount);
+		missesAfter += VertexCacheOptimizer::CalculateACMR(meshIndices, mesh.NumIndices, vertexCount) * (mesh.NumIndices / 3);
+	}
+
+	const float triangleCount = static_cast<float>(numIndices / 3);
+	if (triangleCount > 0.f)
+		std::cout << "Vertex cache ACMR : " << missesBefore / triangleCount << " -> " << missesAfter / triangleCount << std::endl;
+}
+
+/*
+ * Per vertex : vec3 position | 2_10_10_10 snorm normal | half2 texCoord | bone id groups | bone weight groups
+ * 20 + 16 * groupCount bytes instead of 32 + 16 * groupCount in separate streams.
+ * Attribute locations / shader inputs are the same as separate layout.
+ */
+void AnimationModelDatas::UploadInterleaved(const glm::vec3* positionData, const glm::vec2* texCoordData,
+	const glm::vec3* normalData, const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData)
+{
+	const int groupCount = storage->GetGroupCount();
+	const size_t groupBytes = sizeof(glm::u16vec4) * groupCount;
+	const size_t idsOffset = sizeof(glm::vec3) + sizeof(glm::uint) * 2;
+	const size_t weightsOffset = idsOffset + groupBytes;
+	const size_t stride = weightsOffset + groupBytes;
+
+	std::vector<unsigned char> vertices(stride * numVertices);
+
+	for (int i = 0; i < numVertices; ++i)
+	{
+		unsigned char* vertex = vertices.data() + stride * i;
+
+		const glm::uint normal = glm::packSnorm3x10_1x2(glm::vec4(normalData[i], 0.f));
+		const glm::uint texCoord = glm::packHalf2x16(texCoordData[i]);
+
+		std::memcpy(vertex, &positionData[i], sizeof(glm::vec3));
+		std::memcpy(vertex + sizeof(glm::vec3), &normal, sizeof(glm::uint));
+		std::memcpy(vertex + sizeof(glm::vec3) + sizeof(glm::uint), &texCoord, sizeof(glm::uint));
+		std::memcpy(vertex + idsOffset, boneIdData + static_cast<size_t>(i) * groupCount, groupBytes);
+		std::memcpy(vertex + weightsOffset, boneWeightData + static_cast<size_t>(i) * groupCount, groupBytes);
+	}
+
+	vertexBuffer = new Buffer(GL_ARRAY_BUFFER, static_cast<unsigned>(vertices.size()), GL_STATIC_DRAW,
+		vertices.data());
+	vertexBuffer->Bind();
+
+	const GLsizei glStride = static_cast<GLsizei>(stride);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, glStride, (GLvoid*)0);
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, glStride,
+		(GLvoid*)(sizeof(glm::vec3) + sizeof(glm::uint)));
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, glStride, (GLvoid*)sizeof(glm::vec3));
+
+	for (int group = 0; group < groupCount; ++group)
+	{
+		const GLuint idLocation = 3 + 2 * group;
+		glEnableVertexAttribArray(idLocation);
+		glVertexAttribIPointer(idLocation, 4, GL_UNSIGNED_SHORT, glStride,
+			(GLvoid*)(idsOffset + sizeof(glm::u16vec4) * group));
+
+		const GLuint weightLocation = 4 + 2 * group;
+		glEnableVertexAttribArray(weightLocation);
+		glVertexAttribPointer(weightLocation, 4, GL_UNSIGNED_SHORT, GL_TRUE, glStride,
+			(GLvoid*)(weightsOffset + sizeof(glm::u16vec4) * group));
+	}
 }
@@ -15,12 +15,25 @@
 #include <glm/detail/type_vec.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include "AnimationStructure.hpp"
 
 class BoneStorageManager;
 struct aiScene;
 class Buffer;
+class MappedFile;
+
+//Vertex data waiting for GL upload, points into own vectors or into mapped model cache.
+struct VertexStreams
+{
+	const glm::vec3* positions = nullptr;
+	const glm::vec2* texCoords = nullptr;
+	const glm::vec3* normals = nullptr;
+	const glm::u16vec4* boneIds = nullptr;
+	const glm::u16vec4* boneWeights = nullptr;
+	const unsigned* indices = nullptr;
+};
 
 class AnimationModelDatas
 {
@@ -30,6 +43,13 @@ public:
 	void ReserveVectorSpace();
 	void ReserveSpace(const aiScene* scene);
 	void PopulateBuffers(unsigned vao);
+	//PackBones : CPU part of PopulateBuffers, UploadPending : GL part.
+	void PackBones();
+	void UploadPending(unsigned vao);
+	//Upload straight from caller memory (e.g. mapped model cache), storage must already exist.
+	void UploadBuffers(unsigned vao, const glm::vec3* positionData, const glm::vec2* texCoordData,
+		const glm::vec3* normalData, const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData,
+		const unsigned* indexData);
 	void PopulateTransforms(unsigned vao, std::vector<glm::mat4>& transforms);
 
 	std::vector<glm::vec3> positions;
@@ -44,16 +64,30 @@ public:
 	std::vector<BasicMeshEntry> meshes;
 	std::vector<Material> materials;
 
-	Buffer* posBuffer;
-	Buffer* texBuffer;
-	Buffer* normalBuffer;
-	Buffer* indexBuffer;
+	Buffer* posBuffer = nullptr;
+	Buffer* texBuffer = nullptr;
+	Buffer* normalBuffer = nullptr;
+	Buffer* indexBuffer = nullptr;
+	Buffer* boneIdBuffer = nullptr;
+	Buffer* boneWeightBuffer = nullptr;
+	Buffer* vertexBuffer = nullptr;		//interleaved layout
+
+	int numVertices = 0, numIndices = 0;
+	int maxBoneInfluences = DEFAULT_NUM_BONES_PER_VERTEX;
+	//One buffer : position, 2_10_10_10 normal, half texCoord, bone groups.
+	bool interleavedVertices = true;
+	//Reorder each mesh's triangles for post-transform cache before upload / caching.
+	bool optimizeVertexCache = true;
+	unsigned ssboTransforms;
+	BoneStorageManager* storage = nullptr;
 
-	int numVertices, numIndices;
-	unsigned ssboBones, ssboWeights, ssboIndexStarts, ssboIndexEnds, ssboTransforms;
-	BoneStorageManager* storage;
+	VertexStreams pendingStreams;
+	MappedFile* pendingMapping = nullptr;	//kept alive until UploadPending
 
-	void PopulateShaderStorage();
+	void PopulateBoneAttributes(const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData);
 private:
+	void OptimizeIndices();
+	void UploadInterleaved(const glm::vec3* positionData, const glm::vec2* texCoordData,
+		const glm::vec3* normalData, const glm::u16vec4* boneIdData, const glm::u16vec4* boneWeightData);
 
 };
@@ -0,0 +1,273 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Flattened node hierarchy of animating object.
+ */
+
+#include "AnimationSkeleton.h"
+
+#include <cmath>
+#include <string>
+#include <assimp/scene.h>
+
+#include "AnimationModelDatas.h"
+#include "Interpolation.h"
+#include "Quaternion.h"
+
+namespace
+{
+	glm::mat4 ComposeMatrix(const glm::vec4& q, const glm::vec4& t, const glm::vec4& s)
+	{
+		const float x = q.x, y = q.y, z = q.z, w = q.w;
+
+		glm::mat4 result;
+		result[0] = glm::vec4(1.f - 2.f * (y * y + z * z), 2.f * (x * y + z * w), 2.f * (x * z - y * w), 0.f) * s.x;
+		result[1] = glm::vec4(2.f * (x * y - z * w), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + x * w), 0.f) * s.y;
+		result[2] = glm::vec4(2.f * (x * z + y * w), 2.f * (y * z - x * w), 1.f - 2.f * (x * x + y * y), 0.f) * s.z;
+		result[3] = glm::vec4(t.x, t.y, t.z, 1.f);
+
+		return result;
+	}
+}
+
+void LocalPose::Resize(size_t count)
+{
+	rotations.resize(count);
+	translations.resize(count);
+	scales.resize(count);
+}
+
+size_t LocalPose::Size() const
+{
+	return rotations.size();
+}
+
+/*
+ * Flatten node tree breadth first, so parent index is always smaller than child index.
+ * Nodes without animation channel keep their decomposed mTransformation.
+ */
+AnimationSkeleton::AnimationSkeleton(const aiScene* scene, const AnimationModelDatas* datas)
+{
+	std::vector<const aiNode*> nodes;
+	nodes.push_back(scene->mRootNode);
+	parents.push_back(-1);
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		const aiNode* node = nodes[i];
+
+		for (unsigned child = 0; child < node->mNumChildren; ++child)
+		{
+			nodes.push_back(node->mChildren[child]);
+			parents.push_back(static_cast<int>(i));
+		}
+	}
+
+	const size_t nodeCount = nodes.size();
+	boneIndices.resize(nodeCount, -1);
+	bindPose.Resize(nodeCount);
+
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		const auto boneIt = datas->boneName2IndexMap.find(std::string(nodes[i]->mName.data));
+		if (boneIt != datas->boneName2IndexMap.end())
+			boneIndices[i] = static_cast<int>(boneIt->second);
+
+		aiVector3D scaling, position;
+		aiQuaternion rotation;
+		nodes[i]->mTransformation.Decompose(scaling, rotation, position);
+
+		bindPose.rotations[i] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+		bindPose.translations[i] = glm::vec4(position.x, position.y, position.z, 0.f);
+		bindPose.scales[i] = glm::vec4(scaling.x, scaling.y, scaling.z, 0.f);
+	}
+
+	clips.resize(scene->mNumAnimations);
+
+	for (unsigned clipIndex = 0; clipIndex < scene->mNumAnimations; ++clipIndex)
+	{
+		const aiAnimation* animation = scene->mAnimations[clipIndex];
+		ClipInfo& clip = clips[clipIndex];
+
+		clip.animation = animation;
+		clip.durationTicks = static_cast<float>(animation->mDuration);
+		clip.ticksPerSecond = static_cast<float>(animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.f);
+		clip.channels.resize(nodeCount, nullptr);
+
+		for (unsigned channel = 0; channel < animation->mNumChannels; ++channel)
+		{
+			const aiNodeAnim* nodeAnim = animation->mChannels[channel];
+
+			for (size_t i = 0; i < nodeCount; ++i)
+			{
+				if (nodes[i]->mName == nodeAnim->mNodeName)
+				{
+					clip.channels[i] = nodeAnim;
+					break;
+				}
+			}
+		}
+	}
+}
+
+AnimationSkeleton::~AnimationSkeleton()
+{
+	for (ClipInfo& clip : clips)
+		delete clip.compressed;
+}
+
+unsigned AnimationSkeleton::GetNodeCount() const
+{
+	return static_cast<unsigned>(parents.size());
+}
+
+unsigned AnimationSkeleton::GetClipCount() const
+{
+	return static_cast<unsigned>(clips.size());
+}
+
+float AnimationSkeleton::GetClipDurationTicks(unsigned animationIndex) const
+{
+	return clips[animationIndex].durationTicks;
+}
+
+float AnimationSkeleton::GetClipTicksPerSecond(unsigned animationIndex) const
+{
+	return clips[animationIndex].ticksPerSecond;
+}
+
+const LocalPose& AnimationSkeleton::GetBindPose() const
+{
+	return bindPose;
+}
+
+/*
+ * Build compressed copy of every clip. Raw channel pointers are dropped afterwards,
+ * so owner is free to release aiScene.
+ */
+void AnimationSkeleton::Compress(const ClipCompressionSettings& settings)
+{
+	for (ClipInfo& clip : clips)
+	{
+		if (clip.compressed)
+			continue;
+
+		clip.compressed = new CompressedClip(clip.animation, clip.channels, settings);
+		clip.animation = nullptr;
+		std::vector<const aiNodeAnim*>().swap(clip.channels);
+	}
+}
+
+bool AnimationSkeleton::IsCompressed() const
+{
+	for (const ClipInfo& clip : clips)
+	{
+		if (!clip.compressed)
+			return false;
+	}
+	return true;
+}
+
+size_t AnimationSkeleton::GetCompressedMemory() const
+{
+	size_t memory = 0;
+	for (const ClipInfo& clip : clips)
+	{
+		if (clip.compressed)
+			memory += clip.compressed->GetMemory();
+	}
+	return memory;
+}
+
+size_t AnimationSkeleton::GetRawMemory() const
+{
+	size_t memory = 0;
+	for (const ClipInfo& clip : clips)
+	{
+		if (clip.compressed)
+			memory += clip.compressed->GetRawMemory();
+	}
+	return memory;
+}
+
+void AnimationSkeleton::SampleClip(unsigned animationIndex, float timeInSeconds, LocalPose& out) const
+{
+	out.Resize(parents.size());
+
+	if (animationIndex >= clips.size())
+	{
+		out = bindPose;
+		return;
+	}
+
+	const ClipInfo& clip = clips[animationIndex];
+	const float animationTimeTicks = fmod(timeInSeconds * clip.ticksPerSecond, clip.durationTicks);
+
+	const size_t nodeCount = parents.size();
+
+	if (clip.compressed)
+	{
+		for (size_t i = 0; i < nodeCount; ++i)
+		{
+			const unsigned node = static_cast<unsigned>(i);
+
+			out.rotations[i] = bindPose.rotations[i];
+			out.translations[i] = bindPose.translations[i];
+			out.scales[i] = bindPose.scales[i];
+
+			if (clip.compressed->HasTrack(node))
+			{
+				clip.compressed->SampleNode(node, animationTimeTicks,
+					out.rotations[i], out.translations[i], out.scales[i]);
+			}
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		const aiNodeAnim* nodeAnim = clip.channels[i];
+
+		if (!nodeAnim)
+		{
+			out.rotations[i] = bindPose.rotations[i];
+			out.translations[i] = bindPose.translations[i];
+			out.scales[i] = bindPose.scales[i];
+			continue;
+		}
+
+		aiVector3D scaling;
+		Interpolation::CalcInterpolatingScaling(scaling, animationTimeTicks, nodeAnim);
+
+		Quaternion rotation;
+		Interpolation::CalcInterpolatedRotation(rotation, animationTimeTicks, nodeAnim);
+
+		aiVector3D translation;
+		Interpolation::CalcInterpolatedPosition(translation, animationTimeTicks, nodeAnim);
+
+		out.rotations[i] = rotation.GetVec4();
+		out.translations[i] = glm::vec4(translation.x, translation.y, translation.z, 0.f);
+		out.scales[i] = glm::vec4(scaling.x, scaling.y, scaling.z, 0.f);
+	}
+}
+
+/*
+ * Same result as ReadNodeHierarchy, but iterative over flattened nodes.
+ */
+void AnimationSkeleton::BuildTransforms(const LocalPose& pose, const std::vector<BoneInfo>& boneInfos,
+	std::vector<glm::mat4>& globals, glm::mat4* transforms) const
+{
+	const size_t nodeCount = parents.size();
+	globals.resize(nodeCount);
+
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		const glm::mat4 local = ComposeMatrix(pose.rotations[i], pose.translations[i], pose.scales[i]);
+
+		globals[i] = parents[i] < 0 ? local : globals[parents[i]] * local;
+
+		const int boneIndex = boneIndices[i];
+		if (boneIndex >= 0)
+			transforms[boneIndex] = globals[i] * boneInfos[boneIndex].offsetMat;
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Flattened node hierarchy of animating object (parents before children),
+ *                with per clip channel lookup resolved once at load time.
+ *                LocalPose : per node rotation / translation / scale used for blending.
+ *                After Compress, clips are sampled from CompressedClip and no longer touch aiScene.
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include "AnimationStructure.hpp"
+#include "CompressedClip.h"
+
+struct aiAnimation;
+struct aiNodeAnim;
+struct aiScene;
+class AnimationModelDatas;
+
+struct LocalPose
+{
+	void Resize(size_t count);
+	size_t Size() const;
+
+	std::vector<glm::vec4> rotations;		//quaternion (x, y, z, w)
+	std::vector<glm::vec4> translations;	//w unused
+	std::vector<glm::vec4> scales;			//w unused
+};
+
+class AnimationSkeleton
+{
+public:
+	AnimationSkeleton(const aiScene* scene, const AnimationModelDatas* datas);
+	~AnimationSkeleton();
+
+	unsigned GetNodeCount() const;
+	unsigned GetClipCount() const;
+	float GetClipDurationTicks(unsigned animationIndex) const;
+	float GetClipTicksPerSecond(unsigned animationIndex) const;
+	const LocalPose& GetBindPose() const;
+
+	void Compress(const ClipCompressionSettings& settings);
+	bool IsCompressed() const;
+	size_t GetCompressedMemory() const;
+	size_t GetRawMemory() const;
+
+	void SampleClip(unsigned animationIndex, float timeInSeconds, LocalPose& out) const;
+	//globals : caller owned scratch, so one skeleton can be shared between threads.
+	void BuildTransforms(const LocalPose& pose, const std::vector<BoneInfo>& boneInfos,
+		std::vector<glm::mat4>& globals, glm::mat4* transforms) const;
+
+private:
+	friend class ModelCache;
+	AnimationSkeleton() = default;
+
+	struct ClipInfo
+	{
+		float durationTicks;
+		float ticksPerSecond;
+		const aiAnimation* animation;
+		std::vector<const aiNodeAnim*> channels;	//per node, nullptr if not animated
+		CompressedClip* compressed = nullptr;
+	};
+
+	std::vector<int> parents;
+	std::vector<int> boneIndices;	//-1 if node is not a bone
+	std::vector<ClipInfo> clips;
+	LocalPose bindPose;
+};
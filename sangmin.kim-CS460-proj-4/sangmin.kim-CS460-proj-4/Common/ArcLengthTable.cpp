@@ -6,7 +6,11 @@
 
 #include "ArcLengthTable.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <glm/detail/func_geometric.inl>
+#include <glm/common.hpp>
 
 #include "CubicSpline.h"
 
@@ -16,141 +20,273 @@ ArcLengthTable::ArcLengthTable()
 ArcLengthTable::~ArcLengthTable()
 = default;
 
-void ArcLengthTable::SetTable(CubicSpline* spline)
+/*
+ * 5 point Gauss-Legendre, exact for polynomial of degree 9.
+ * |spline'(t)| is square root of a quartic so it is only approximated.
+ */
+double ArcLengthTable::IntegrateLength(const CubicSpline& spline, double t0, double t1)
 {
-	std::vector<ArcLengthTableValue> tableValue;
+	static const double nodes[5] = { 0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+	static const double weights[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
+
+	const double halfRange = 0.5 * (t1 - t0);
+	const double center = 0.5 * (t1 + t0);
 
-	if(forTheFirstTime)
+	double result = 0.0;
+	for(int i = 0; i < 5; ++i)
 	{
-		tableValue.push_back(ArcLengthTableValue{ startParam, 0.0 });
-		startParam += distanceBtwEntries;
-		forTheFirstTime = false;
+		const float t = static_cast<float>(center + halfRange * nodes[i]);
+		result += weights[i] * static_cast<double>(glm::length(spline.InterpolateDerivative(t)));
 	}
 
-	for(double t = startParam; t <= startParam + 1.0; t += distanceBtwEntries)
+	return result * halfRange;
+}
+
+/*
+ * Split [t0, t1] until both halves sum to the whole within tolerance,
+ * then add the end of the interval as an entry (start is already in the table).
+ */
+static void Subdivide(const CubicSpline& spline, double t0, double t1, double length, double& arcLength,
+	double tolerance, int depth, std::vector<ArcLengthTableValue>& entries)
+{
+	const double tMiddle = 0.5 * (t0 + t1);
+	const double left = ArcLengthTable::IntegrateLength(spline, t0, tMiddle);
+	const double right = ArcLengthTable::IntegrateLength(spline, tMiddle, t1);
+
+	if(depth <= 0 || std::abs(left + right - length) <= tolerance)
 	{
-		glm::vec3 pos1 = spline->Interpolate(t - 0.005);
-		glm::vec3 pos2 = spline->Interpolate(t);
+		arcLength += left + right;
+		entries.push_back(ArcLengthTableValue{ t1, arcLength });
+		return;
+	}
+
+	Subdivide(spline, t0, tMiddle, left, arcLength, tolerance, depth - 1, entries);
+	Subdivide(spline, tMiddle, t1, right, arcLength, tolerance, depth - 1, entries);
+}
+
+double ArcLengthTable::BuildEntries(const CubicSpline& spline, double tolerance, int maxDepth,
+	std::vector<ArcLengthTableValue>& entries)
+{
+	double arcLength = 0.0;
+
+	Subdivide(spline, 0.0, 1.0, IntegrateLength(spline, 0.0, 1.0), arcLength, tolerance, maxDepth, entries);
+
+	return arcLength;
+}
 
-		const double distance = static_cast<double>(glm::distance(pos1, pos2));
+void ArcLengthTable::SetTable(const CubicSpline* spline)
+{
+	std::vector<ArcLengthTableValue> tableValue;
 
-		ArcLengthTableValue val{};
+	if(splines.empty())
+		tableValue.push_back(ArcLengthTableValue{ 0.0, 0.0 });
 
-		val.parametric = t;
-		val.arcLength = distance + prevArcLength;
+	const size_t firstEntry = tableValue.size();
+	const double splineStart = static_cast<double>(splines.size());
 
+	splines.push_back(spline);
 
-		tableValue.push_back(val);
+	const double length = BuildEntries(*spline, lengthTolerance, maxSubdivisionDepth, tableValue);
 
-		prevArcLength = val.arcLength;
+	//local t, s to whole path
+	for(size_t i = firstEntry; i < tableValue.size(); ++i)
+	{
+		tableValue[i].parametric += splineStart;
+		tableValue[i].arcLength += prevArcLength;
 	}
 
-	table.push_back(tableValue);
+	prevArcLength += length;
 
-	startParam += 1.0;
+	table.push_back(tableValue);
 }
 
 void ArcLengthTable::FinializeTable()
 {
 	const size_t tablesCount = table.size();
-	double maximumArcLength = 0.0;
+	size_t totalSize = 0;
+	for (size_t i = 0; i < tablesCount; ++i)
+		totalSize += table[i].size();
+
+	finalTable.clear();
+	finalTable.reserve(totalSize);
 
 	for(size_t i = 0; i < tablesCount; ++i)
 	{
-		std::vector<ArcLengthTableValue> table_ = table[i];
-
-		const size_t tableSize = table_.size();
+		finalTable.insert(finalTable.end(), table[i].begin(), table[i].end());
+	}
 
-		for(size_t j = 0; j < tableSize; ++j)
-		{
-			ArcLengthTableValue val = table_[j];
+	//per spline tables are not used after this point
+	std::vector<std::vector<ArcLengthTableValue>>().swap(table);
 
-			if (val.arcLength > maximumArcLength)
-				maximumArcLength = val.arcLength;
+	totalLength = prevArcLength;
 
-			finalTable.push_back(val);
-		}
+	//no spline : identity table, s = u, so lookups below always have a segment to read
+	if (splines.empty())
+	{
+		finalTable.assign({ ArcLengthTableValue{ 0.0, 0.0 }, ArcLengthTableValue{ 1.0, 1.0 } });
+		inverseTable.assign({ 0.0, 1.0 });
+		inverseScale = 1.0;
+		return;
 	}
 
-	const float maxN = static_cast<float>(tablesCount);
-
-	const size_t totalSize = finalTable.size();
+	const double maxN = static_cast<double>(tablesCount);
+	//zero length path keeps s = 0 everywhere
+	const double invLength = totalLength > 0.0 ? 1.0 / totalLength : 0.0;
 
 	for(size_t i = 0; i < totalSize; ++i)
 	{
 		finalTable[i].parametric /= maxN;
-		finalTable[i].arcLength /= maximumArcLength;
+		finalTable[i].arcLength *= invLength;
 	}
 
-	distanceBtwEntries = finalTable[1].parametric;
+	BuildInverseTable();
+}
+
+/*
+ * Entry segment [segment, segment + 1] never crosses a spline boundary,
+ * so its middle tells which spline it belongs to.
+ */
+int ArcLengthTable::GetSplineIndex(int segment) const
+{
+	const double middle = 0.5 * (finalTable[segment].parametric + finalTable[segment + 1].parametric);
+	const int index = static_cast<int>(middle * static_cast<double>(splines.size()));
 
+	return index < static_cast<int>(splines.size()) ? index : static_cast<int>(splines.size()) - 1;
 }
 
-int ArcLengthTable::GetClosestIndex(double u)
+double ArcLengthTable::LocalParam(double u, int splineIndex) const
 {
-	const double uDivDu = u / distanceBtwEntries;
-	int result = static_cast<int>(uDivDu);
+	return u * static_cast<double>(splines.size()) - static_cast<double>(splineIndex);
+}
 
-	if (result >= static_cast<int>(finalTable.size()))
-		result = static_cast<int>(finalTable.size()) - 1;
+/*
+ * Walk finalTable once, both s sequences are increasing.
+ * Inside an entry segment a few Newton steps on s(t) = s0 + integral |spline'|
+ * give u, so sparse entries on the forward table do not cost accuracy.
+ * inverseTable[k] = u(k / (size - 1))
+ */
+void ArcLengthTable::BuildInverseTable()
+{
+	const size_t size = inverseTableSize < 2 ? 2 : inverseTableSize;
+	const size_t lastEntry = finalTable.size() - 1;
+	const double splineCount = static_cast<double>(splines.size());
 
-	return result;
+	inverseTable.resize(size);
+	inverseScale = static_cast<double>(size - 1);
+
+	size_t entry = 0;
+
+	for(size_t k = 0; k < size; ++k)
+	{
+		const double s = static_cast<double>(k) / inverseScale;
+
+		while (entry + 1 < lastEntry && finalTable[entry + 1].arcLength < s)
+			++entry;
+
+		const ArcLengthTableValue& v0 = finalTable[entry];
+		const ArcLengthTableValue& v1 = finalTable[entry + 1];
+
+		const int splineIndex = GetSplineIndex(static_cast<int>(entry));
+		const CubicSpline* spline = splines[splineIndex];
+
+		const double t0 = LocalParam(v0.parametric, splineIndex);
+		const double t1 = LocalParam(v1.parametric, splineIndex);
+		const double target = (s - v0.arcLength) * totalLength;
+
+		const double ds = v1.arcLength - v0.arcLength;
+		double t = t0 + (ds > 0.0 ? (s - v0.arcLength) / ds : 0.0) * (t1 - t0);
+
+		for(int i = 0; i < 4; ++i)
+		{
+			const double speed = static_cast<double>(glm::length(spline->InterpolateDerivative(static_cast<float>(t))));
+			if (speed <= 0.0)
+				break;
+
+			t -= (IntegrateLength(*spline, t0, t) - target) / speed;
+			t = glm::clamp(t, t0, t1);
+		}
+
+		inverseTable[k] = (static_cast<double>(splineIndex) + t) / splineCount;
+	}
 }
 
-double ArcLengthTable::GetArcLength(double u)
+int ArcLengthTable::GetClosestIndex(double u) const
 {
-	double du = distanceBtwEntries;
+	//last entry with parametric <= u, GetArcLength reads result + 1
+	if (finalTable.size() < 2)
+		return 0;
 
-	const int index = GetClosestIndex(u);
+	const auto it = std::upper_bound(finalTable.begin(), finalTable.end(), u,
+		[](double value, const ArcLengthTableValue& entry) { return value < entry.parametric; });
+
+	int result = static_cast<int>(it - finalTable.begin()) - 1;
 
-	double ui = finalTable[index].parametric;
+	if (result >= static_cast<int>(finalTable.size()) - 1)
+		result = static_cast<int>(finalTable.size()) - 2;
+	if (result < 0)
+		result = 0;
 
-	double k = (u - ui) / du;
+	return result;
+}
+
+double ArcLengthTable::GetArcLength(double u) const
+{
+	if (finalTable.size() < 2 || splines.empty() || totalLength <= 0.0)
+		return glm::clamp(u, 0.0, 1.0);
+
+	const int index = GetClosestIndex(u);
+	const int splineIndex = GetSplineIndex(index);
 
-	double si = finalTable[index].arcLength;
-	double nextSi = finalTable[index + 1].arcLength;
+	const double t0 = LocalParam(finalTable[index].parametric, splineIndex);
+	const double t = glm::clamp(LocalParam(u, splineIndex), 0.0, 1.0);
 
-	double s = si + k * (nextSi - si);
+	const double s = finalTable[index].arcLength + IntegrateLength(*splines[splineIndex], t0, t) / totalLength;
 
 	return s;
 }
 
-double ArcLengthTable::GetParamValue(double s)
+double ArcLengthTable::GetParamValue(double s) const
 {
-	//bin search
-	int closestIndex;
-	
-	double uMin = 0.0;
-	double uMax = 1.0;
+	//FinializeTable not called yet
+	if (inverseTable.size() < 2)
+		return glm::clamp(s, 0.0, 1.0);
 
-	double diff;
-	double midDiff;
-	int loopCount = 0;
+	if (s <= 0.0)
+		return inverseTable.front();
+	if (s >= 1.0)
+		return inverseTable.back();
 
-	do
-	{
-		const double uMiddle = (uMin + uMax) / 2.0;
-		closestIndex = GetClosestIndex(uMiddle);
-
-		const int prevIndex = closestIndex - 1;
+	const double position = s * inverseScale;
+	const size_t index = static_cast<size_t>(position);
+	const double k = position - static_cast<double>(index);
 
-		const double distanceValue = finalTable[closestIndex].arcLength;
+	return inverseTable[index] + k * (inverseTable[index + 1] - inverseTable[index]);
+}
 
-		midDiff =
-			abs(finalTable[closestIndex].arcLength - finalTable[prevIndex].arcLength);
+void ArcLengthTable::GetParamValues(const float* s, float* u, size_t count) const
+{
+	if (inverseTable.size() < 2)
+	{
+		for(size_t i = 0; i < count; ++i)
+			u[i] = glm::clamp(s[i], 0.f, 1.f);
+		return;
+	}
 
-		diff = abs(distanceValue - s);
+	const float scale = static_cast<float>(inverseScale);
+	const size_t lastIndex = inverseTable.size() - 2;
+	const double* values = inverseTable.data();
 
-		if(distanceValue > s)
-			uMax = uMiddle;
-		else
-			uMin = uMiddle;
+	for(size_t i = 0; i < count; ++i)
+	{
+		const float position = glm::clamp(s[i], 0.f, 1.f) * scale;
+		size_t index = static_cast<size_t>(position);
+		if (index > lastIndex)
+			index = lastIndex;
 
-		loopCount++;
+		const float k = position - static_cast<float>(index);
+		const float u0 = static_cast<float>(values[index]);
+		const float u1 = static_cast<float>(values[index + 1]);
 
-		if (loopCount > 50)
-			break;
-	} while (diff > midDiff);
-	
-	return finalTable[closestIndex].parametric;
+		u[i] = u0 + k * (u1 - u0);
+	}
 }
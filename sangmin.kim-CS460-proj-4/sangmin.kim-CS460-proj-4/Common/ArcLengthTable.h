@@ -2,9 +2,14 @@
  * Author		: Ryan Kim.
  * Date			: 2022-11-07
  * Description	: Functions for build arc length table.
+ *                Entries are placed by adaptive subdivision, segment length is
+ *                Gauss-Legendre quadrature of |spline'(t)|. Straight parts get few entries.
+ *                FinializeTable also builds an inverse table sampled uniformly in s,
+ *                so GetParamValue is one index and one lerp.
  */
 
 #pragma once
+#include <cstddef>
 #include <vector>
 
 class CubicSpline;
@@ -24,18 +29,40 @@ public:
 	std::vector<std::vector<ArcLengthTableValue>> table;
 	std::vector<ArcLengthTableValue> finalTable;
 
-	void SetTable(CubicSpline* spline);
+	void SetTable(const CubicSpline* spline);
 	void FinializeTable();
 
-	int GetClosestIndex(double u);
-	double GetArcLength(double u);
-	double GetParamValue(double s);
-	double distanceBtwEntries = 0.005;
+	int GetClosestIndex(double u) const;
+	double GetArcLength(double u) const;
+	double GetParamValue(double s) const;
+	//s, u normalized to [0, 1]
+	void GetParamValues(const float* s, float* u, size_t count) const;
+	double GetTotalLength() const { return totalLength; }
 
+	//length of spline over [t0, t1]
+	static double IntegrateLength(const CubicSpline& spline, double t0, double t1);
+	//appends (local t, local s) entries for t in (0, 1], returns spline length
+	static double BuildEntries(const CubicSpline& spline, double tolerance, int maxDepth,
+		std::vector<ArcLengthTableValue>& entries);
+
+	//world unit error allowed per subdivided segment, set before SetTable
+	double lengthTolerance = 1e-4;
+	int maxSubdivisionDepth = 12;
+	//entries of inverse table, set before FinializeTable
+	size_t inverseTableSize = 2048;
 
-private:
-	bool forTheFirstTime = true;
 
-	double startParam = 0.0;
+private:
 	double prevArcLength = 0.0;
-};
\ No newline at end of file
+	double totalLength = 0.0;
+
+	//not owned
+	std::vector<const CubicSpline*> splines;
+
+	int GetSplineIndex(int segment) const;
+	double LocalParam(double u, int splineIndex) const;
+	void BuildInverseTable();
+
+	std::vector<double> inverseTable;
+	double inverseScale = 0.0;
+};
@@ -0,0 +1,138 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Asynchronous asset loading.
+ */
+
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <iostream>
+#include <GL/glew.h>
+
+#include "AnimationModel.h"
+#include "JobSystem.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+AssetLoader::AssetLoader(JobSystem* jobSystemVal) : jobSystem(jobSystemVal), loadingCount(0), pendingCount(0)
+{
+}
+
+/*
+ * Worker parts still running reference this loader, wait for them.
+ * Uploads not pumped yet are dropped, their handles never become ready.
+ */
+AssetLoader::~AssetLoader()
+{
+	std::unique_lock<std::mutex> lock(loadingMutex);
+	loadingCondition.wait(lock, [this]() { return loadingCount.load() == 0; });
+}
+
+/*
+ * Decoded through TextureCache on worker, so same file is shared with models' materials.
+ */
+AssetHandle<Texture> AssetLoader::LoadTexture(const std::string& path)
+{
+	AssetHandle<Texture> handle;
+	handle.slot = std::make_shared<AssetHandle<Texture>::Slot>();
+
+	auto slot = handle.slot;
+
+	++loadingCount;
+	++pendingCount;
+	jobSystem->Submit([this, slot, path]()
+		{
+			Texture* texture = TextureCache::Get().Acquire(path);
+
+			QueueUpload([slot, texture]()
+				{
+					slot->asset = texture;
+
+					if (texture && texture->Upload())
+						slot->ready = true;
+					else
+						slot->failed = true;
+				});
+			FinishLoad();
+		});
+
+	return handle;
+}
+
+/*
+ * VAO / ssbo are created here on GL thread, import or cache read runs on worker.
+ */
+AssetHandle<AnimationModel> AssetLoader::LoadModel(Shader* shader, const std::string& path, int maxBoneInfluences)
+{
+	AssetHandle<AnimationModel> handle;
+	handle.slot = std::make_shared<AssetHandle<AnimationModel>::Slot>();
+	handle.slot->asset = new AnimationModel(shader, path, maxBoneInfluences, true);
+
+	auto slot = handle.slot;
+
+	++loadingCount;
+	++pendingCount;
+	jobSystem->Submit([this, slot]()
+		{
+			const bool loaded = slot->asset->LoadData();
+
+			QueueUpload([slot, loaded]()
+				{
+					if (loaded)
+					{
+						slot->asset->UploadData();
+						slot->ready = true;
+					}
+					else
+						slot->failed = true;
+				});
+			FinishLoad();
+		});
+
+	return handle;
+}
+
+void AssetLoader::PumpUploads(float budgetMilliseconds)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		std::function<void()> upload;
+
+		{
+			std::lock_guard<std::mutex> lock(uploadMutex);
+			if (uploads.empty())
+				return;
+
+			upload = std::move(uploads.front());
+			uploads.pop_front();
+		}
+
+		upload();
+		--pendingCount;
+
+		const float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= budgetMilliseconds)
+			return;
+	}
+}
+
+unsigned AssetLoader::GetPendingCount() const
+{
+	return pendingCount.load();
+}
+
+void AssetLoader::QueueUpload(std::function<void()> upload)
+{
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	uploads.push_back(std::move(upload));
+}
+
+void AssetLoader::FinishLoad()
+{
+	std::lock_guard<std::mutex> lock(loadingMutex);
+	--loadingCount;
+	loadingCondition.notify_all();
+}
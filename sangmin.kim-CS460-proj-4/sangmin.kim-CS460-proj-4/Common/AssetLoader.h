@@ -0,0 +1,94 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Asynchronous asset loading.
+ *                File reading / decoding / parsing runs on JobSystem workers,
+ *                GL uploads are queued and run on GL thread by PumpUploads within time budget per frame.
+ *                AssetHandle becomes ready after its upload. Models are owned by caller
+ *                (delete them after AssetLoader), textures by TextureCache.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "VertexBoneData.hpp"
+
+class AnimationModel;
+class JobSystem;
+class Shader;
+class Texture;
+
+template <typename T>
+class AssetHandle
+{
+public:
+	bool IsReady() const
+	{
+		return slot && slot->ready;
+	}
+
+	bool IsFailed() const
+	{
+		return slot && slot->failed;
+	}
+
+	//nullptr until ready
+	T* Get() const
+	{
+		return IsReady() ? slot->asset : nullptr;
+	}
+
+	//asset object itself, models : available right away (for ownership)
+	T* GetAsset() const
+	{
+		return slot ? slot->asset : nullptr;
+	}
+
+private:
+	friend class AssetLoader;
+
+	struct Slot
+	{
+		T* asset = nullptr;
+		bool ready = false;
+		bool failed = false;
+	};
+
+	std::shared_ptr<Slot> slot;
+};
+
+class AssetLoader
+{
+public:
+	AssetLoader(JobSystem* jobSystemVal);
+	~AssetLoader();
+
+	AssetHandle<Texture> LoadTexture(const std::string& path);
+	AssetHandle<AnimationModel> LoadModel(Shader* shader, const std::string& path,
+		int maxBoneInfluences = DEFAULT_NUM_BONES_PER_VERTEX);
+
+	//GL thread, once per frame. At least one upload runs even if it exceeds budget.
+	void PumpUploads(float budgetMilliseconds);
+	unsigned GetPendingCount() const;
+
+private:
+	void QueueUpload(std::function<void()> upload);
+	void FinishLoad();
+
+	JobSystem* jobSystem;
+
+	std::mutex uploadMutex;
+	std::deque<std::function<void()>> uploads;
+
+	std::atomic<unsigned> loadingCount;	//submitted, worker part not finished yet
+	std::atomic<unsigned> pendingCount;	//submitted, upload not finished yet
+	std::mutex loadingMutex;
+	std::condition_variable loadingCondition;
+};
@@ -0,0 +1,189 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for bake every clip of animating object into bone palette.
+ */
+
+#include "BakedAnimation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+#include <glm/packing.hpp>
+
+#include "AnimationModel.h"
+#include "AnimationSkeleton.h"
+#include "JobSystem.h"
+
+/*
+ * Frame f of a clip is sampled at f / frameRate seconds, frameCount = floor(duration * frameRate) + 1
+ * so the last frame is the last one inside the clip. Shader wraps time on duration and blends
+ * the last frame back to frame 0 over what is left of the clip, loops stay in step with CPU sampling.
+ */
+BakedAnimation::BakedAnimation(AnimationModel* model, float frameRate, BakedFormat format_, JobSystem* jobSystem)
+{
+	format = format_;
+	boneCount = model->GetBoneCount();
+
+	const AnimationSkeleton* skeleton = model->skeleton;
+	const unsigned clipCount = skeleton->GetClipCount();
+
+	clips.resize(clipCount);
+
+	glm::uint totalMatrices = 0;
+	for (unsigned i = 0; i < clipCount; ++i)
+	{
+		const float durationSeconds = skeleton->GetClipDurationTicks(i) / skeleton->GetClipTicksPerSecond(i);
+
+		BakedClipInfo& clip = clips[i];
+		clip.firstMatrix = totalMatrices;
+		clip.frameCount = static_cast<glm::uint>(std::floor(std::max(0.f, durationSeconds * frameRate))) + 1;
+		clip.frameRate = frameRate;
+		clip.duration = durationSeconds;
+
+		totalMatrices += clip.frameCount * boneCount;
+	}
+
+	if (format == BakedFormat::FLOAT_3X4)
+		floatRows.resize(static_cast<size_t>(totalMatrices) * 3);
+	else
+		halfRows.resize(static_cast<size_t>(totalMatrices) * 3);
+
+	std::vector<std::pair<unsigned, glm::uint>> frames;
+	for (unsigned i = 0; i < clipCount; ++i)
+		for (glm::uint frame = 0; frame < clips[i].frameCount; ++frame)
+			frames.emplace_back(i, frame);
+
+	auto bakeFrame = [&](unsigned index)
+	{
+		const unsigned clipIndex = frames[index].first;
+		const glm::uint frame = frames[index].second;
+		const BakedClipInfo& clip = clips[clipIndex];
+
+		LocalPose pose;
+		std::vector<glm::mat4> globals;
+		std::vector<glm::mat4> transforms(boneCount);
+
+		skeleton->SampleClip(clipIndex, static_cast<float>(frame) / clip.frameRate, pose);
+		skeleton->BuildTransforms(pose, model->datas->boneInfos, globals, transforms.data());
+
+		const size_t firstMatrix = clip.firstMatrix + static_cast<size_t>(frame) * boneCount;
+		for (unsigned bone = 0; bone < boneCount; ++bone)
+			StoreMatrix(firstMatrix + bone, transforms[bone]);
+	};
+
+	const unsigned framesSize = static_cast<unsigned>(frames.size());
+	if (jobSystem)
+		jobSystem->ParallelFor(framesSize, bakeFrame, 4);
+	else
+		for (unsigned i = 0; i < framesSize; ++i)
+			bakeFrame(i);
+
+	glGenBuffers(1, &paletteBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, paletteBuffer);
+	if (format == BakedFormat::FLOAT_3X4)
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4) * floatRows.size(), floatRows.data(), GL_STATIC_DRAW);
+	else
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::uvec2) * halfRows.size(), halfRows.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &clipBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, clipBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(BakedClipInfo) * clips.size(), clips.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	//data lives on GPU now
+	std::vector<glm::vec4>().swap(floatRows);
+	std::vector<glm::uvec2>().swap(halfRows);
+
+	PrintMemoryReport();
+}
+
+BakedAnimation::~BakedAnimation()
+{
+	glDeleteBuffers(1, &paletteBuffer);
+	glDeleteBuffers(1, &clipBuffer);
+}
+
+/*
+ * Palette is bound to both 5 (vec4 rows) and 6 (half rows), shader picks by bakedFormat.
+ */
+void BakedAnimation::Bind()
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, paletteBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, paletteBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, clipBuffer);
+}
+
+unsigned BakedAnimation::GetClipCount() const
+{
+	return static_cast<unsigned>(clips.size());
+}
+
+unsigned BakedAnimation::GetBoneCount() const
+{
+	return boneCount;
+}
+
+BakedFormat BakedAnimation::GetFormat() const
+{
+	return format;
+}
+
+const BakedClipInfo& BakedAnimation::GetClip(unsigned animationIndex) const
+{
+	return clips[animationIndex];
+}
+
+size_t BakedAnimation::GetClipMemory(unsigned animationIndex) const
+{
+	return static_cast<size_t>(clips[animationIndex].frameCount) * boneCount * GetMatrixBytes();
+}
+
+size_t BakedAnimation::GetTotalMemory() const
+{
+	size_t total = sizeof(BakedClipInfo) * clips.size();
+
+	const unsigned clipCount = GetClipCount();
+	for (unsigned i = 0; i < clipCount; ++i)
+		total += GetClipMemory(i);
+
+	return total;
+}
+
+void BakedAnimation::PrintMemoryReport() const
+{
+	const unsigned clipCount = GetClipCount();
+	for (unsigned i = 0; i < clipCount; ++i)
+	{
+		std::cout << "Baked clip " << i << " : " << clips[i].frameCount << " frames, "
+			<< GetClipMemory(i) / 1024.0 << " KB" << std::endl;
+	}
+
+	std::cout << "Baked total : " << GetTotalMemory() / 1024.0 << " KB ("
+		<< (format == BakedFormat::FLOAT_3X4 ? "float" : "half") << " 3x4)" << std::endl;
+}
+
+size_t BakedAnimation::GetMatrixBytes() const
+{
+	return format == BakedFormat::FLOAT_3X4 ? sizeof(glm::vec4) * 3 : sizeof(glm::uvec2) * 3;
+}
+
+/*
+ * Last row of bone matrix is always (0, 0, 0, 1), only first 3 rows are stored.
+ */
+void BakedAnimation::StoreMatrix(size_t matrixIndex, const glm::mat4& matrix)
+{
+	for (int row = 0; row < 3; ++row)
+	{
+		const glm::vec4 rowValue(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+		const size_t rowIndex = matrixIndex * 3 + row;
+
+		if (format == BakedFormat::FLOAT_3X4)
+			floatRows[rowIndex] = rowValue;
+		else
+			halfRows[rowIndex] = glm::uvec2(glm::packHalf2x16(glm::vec2(rowValue.x, rowValue.y)),
+				glm::packHalf2x16(glm::vec2(rowValue.z, rowValue.w)));
+	}
+}
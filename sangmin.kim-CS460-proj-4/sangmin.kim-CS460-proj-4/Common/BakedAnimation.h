@@ -0,0 +1,68 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for bake every clip of animating object at fixed rate
+ *                into one contiguous bone palette (3x4 matrices) in SSBO.
+ *                Vertex shader reads nearest / two blended samples, so playback costs no CPU.
+ *                HALF_3X4 stores half floats (24 bytes per bone instead of 48).
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+class AnimationModel;
+class JobSystem;
+
+enum class BakedFormat
+{
+	FLOAT_3X4 = 0,
+	HALF_3X4
+};
+
+//std430 layout, matches BakedClip in bakedVert.glsl
+struct BakedClipInfo
+{
+	glm::uint firstMatrix;
+	glm::uint frameCount;
+	float frameRate;
+	//seconds, playback wraps on this and not on frameCount / frameRate
+	float duration;
+};
+
+class BakedAnimation
+{
+public:
+	BakedAnimation(AnimationModel* model, float frameRate = 30.f,
+		BakedFormat format = BakedFormat::FLOAT_3X4, JobSystem* jobSystem = nullptr);
+	~BakedAnimation();
+
+	void Bind();
+
+	unsigned GetClipCount() const;
+	unsigned GetBoneCount() const;
+	BakedFormat GetFormat() const;
+	const BakedClipInfo& GetClip(unsigned animationIndex) const;
+
+	size_t GetClipMemory(unsigned animationIndex) const;
+	size_t GetTotalMemory() const;
+	void PrintMemoryReport() const;
+
+private:
+	size_t GetMatrixBytes() const;
+	void StoreMatrix(size_t matrixIndex, const glm::mat4& matrix);
+
+	BakedFormat format;
+	unsigned boneCount;
+	std::vector<BakedClipInfo> clips;
+
+	//3 rows per matrix, only one of them is used depending on format
+	std::vector<glm::vec4> floatRows;
+	std::vector<glm::uvec2> halfRows;
+
+	unsigned paletteBuffer;
+	unsigned clipBuffer;
+};
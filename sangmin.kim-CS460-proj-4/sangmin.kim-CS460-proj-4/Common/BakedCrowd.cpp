@@ -0,0 +1,107 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for draw many instances of one animating object from BakedAnimation.
+ */
+
+#include "BakedCrowd.h"
+
+#include <GL/glew.h>
+
+#include "AnimationModel.h"
+#include "BakedAnimation.h"
+#include "BoneStorageManager.h"
+#include "Shader.h"
+#include "Texture.h"
+
+BakedCrowd::BakedCrowd(AnimationModel* model_, BakedAnimation* baked_, Shader* shader_)
+{
+	model = model_;
+	baked = baked_;
+	shader = shader_;
+
+	glGenBuffers(1, &instanceBuffer);
+}
+
+BakedCrowd::~BakedCrowd()
+{
+	glDeleteBuffers(1, &instanceBuffer);
+}
+
+unsigned BakedCrowd::AddInstance(const glm::mat4& world, unsigned animationIndex, float timeOffset, float speed)
+{
+	if (animationIndex >= baked->GetClipCount())
+		animationIndex = 0;
+
+	BakedInstance instance;
+	instance.world = world;
+	instance.playback = glm::vec4(static_cast<float>(animationIndex), timeOffset, speed, 0.f);
+
+	instances.push_back(instance);
+	dirty = true;
+
+	return static_cast<unsigned>(instances.size() - 1);
+}
+
+void BakedCrowd::Clear()
+{
+	instances.clear();
+	dirty = true;
+}
+
+void BakedCrowd::Upload()
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+
+	//same count every frame when instances move, keep the storage
+	if (uploadedCount == instances.size())
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(BakedInstance) * instances.size(), instances.data());
+	else
+	{
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(BakedInstance) * instances.size(),
+			instances.data(), GL_DYNAMIC_DRAW);
+		uploadedCount = instances.size();
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	dirty = false;
+}
+
+void BakedCrowd::Draw(const glm::mat4& projViewMat, float time)
+{
+	if (instances.empty())
+		return;
+
+	if (dirty)
+		Upload();
+
+	shader->Use();
+	model->Select();
+
+	baked->Bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, instanceBuffer);
+
+	shader->SendUniformMatGLM("gVP", projViewMat);
+	shader->SendUniformFloat("time", time);
+	shader->SendUniformInt("boneCount", static_cast<int>(baked->GetBoneCount()));
+	shader->SendUniformInt("bakedFormat", static_cast<int>(baked->GetFormat()));
+	shader->SendUniformInt("blendFrames", blendFrames ? 1 : 0);
+	shader->SendUniformInt("influenceCount", model->datas->storage->GetInfluenceCount());
+	shader->SendUniformInt("displayTexture", static_cast<int>(model->isTextured));
+
+	const GLsizei instanceCount = static_cast<GLsizei>(instances.size());
+	const unsigned meshesSize = static_cast<unsigned>(model->datas->meshes.size());
+	for (unsigned i = 0; i < meshesSize; ++i)
+	{
+		const BasicMeshEntry& mesh = model->datas->meshes[i];
+
+		if (model->datas->materials[mesh.MaterialIndex].pDiffuse)
+			model->datas->materials[mesh.MaterialIndex].pDiffuse->Bind(GL_TEXTURE0);
+
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.NumIndices, GL_UNSIGNED_INT,
+			(void*)(sizeof(unsigned int) * mesh.BaseIndex), instanceCount, mesh.BaseVertex);
+	}
+
+	glBindVertexArray(0);
+}
@@ -0,0 +1,50 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for draw many instances of one animating object from BakedAnimation
+ *                with single instanced draw per mesh. Per instance world matrix / clip / time offset
+ *                is stored in SSBO, so CPU only uploads when instances change.
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+class AnimationModel;
+class BakedAnimation;
+class Shader;
+
+//std430 layout, matches BakedInstance in bakedVert.glsl
+struct BakedInstance
+{
+	glm::mat4 world;
+	glm::vec4 playback;	//x : clip, y : time offset, z : speed
+};
+
+class BakedCrowd
+{
+public:
+	BakedCrowd(AnimationModel* model_, BakedAnimation* baked_, Shader* shader_);
+	~BakedCrowd();
+
+	unsigned AddInstance(const glm::mat4& world, unsigned animationIndex, float timeOffset, float speed = 1.f);
+	void Clear();
+	void Upload();
+	//instances edited in place (e.g. by PathAgents::Update)
+	void MarkDirty() { dirty = true; }
+	void Draw(const glm::mat4& projViewMat, float time);
+
+	std::vector<BakedInstance> instances;
+	//false : nearest sample only
+	bool blendFrames = true;
+
+private:
+	AnimationModel* model;
+	BakedAnimation* baked;
+	Shader* shader;
+
+	unsigned instanceBuffer;
+	size_t uploadedCount = 0;
+	bool dirty = false;
+};
@@ -1,44 +1,94 @@
 /*
  * Author		: Ryan Kim.
  * Date			: 2022-10-07
- * Description	: Class for populate SSBOs of animating object.
+ * Description	: Class for pack bone ids / weights of animating object into vertex attributes.
  */
 
 
 #include "BoneStorageManager.h"
 
+#include <algorithm>
+#include <cmath>
 
-BoneStorageManager::BoneStorageManager(const std::vector<VertexBoneData>& boneInfos)
+
+BoneStorageManager::BoneStorageManager(const std::vector<VertexBoneData>& boneInfos, int maxInfluences)
 {
+	influenceCount = std::min(std::max(maxInfluences, 1), MAX_PACKED_BONES_PER_VERTEX);
+	groupCount = (influenceCount + 3) / 4;
+
 	const size_t size = boneInfos.size();
-	int start = 0;
-	int end = 0;
 
-	for(size_t i = 0 ; i < size; ++i)
-	{
-		const VertexBoneData info = boneInfos[i];
+	boneIds.reserve(size * groupCount);
+	weights.reserve(size * groupCount);
 
-		for(int j = 0; j < MAX_NUM_BONES_PER_VERTEX; ++j)
-		{
-			float weight = info.Weights[j];
-			int id = static_cast<int>(info.BoneIDs[j]);
+	for (size_t i = 0; i < size; ++i)
+		PackVertex(boneInfos[i]);
+}
 
-			bones.push_back(id);
-			weights.push_back(weight);
-			end++;
-			
-		}
-		indexStarts.push_back(start);
-		indexEnds.push_back(end);
-		start = end;
-	}
+BoneStorageManager::BoneStorageManager(int maxInfluences)
+{
+	influenceCount = std::min(std::max(maxInfluences, 1), MAX_PACKED_BONES_PER_VERTEX);
+	groupCount = (influenceCount + 3) / 4;
+}
 
-	
+BoneStorageManager::~BoneStorageManager()
+{
 
+}
 
+int BoneStorageManager::GetInfluenceCount() const
+{
+	return influenceCount;
 }
 
-BoneStorageManager::~BoneStorageManager()
+int BoneStorageManager::GetGroupCount() const
+{
+	return groupCount;
+}
+
+/*
+ * Keep top-N weights of the vertex, renormalize them to sum 1,
+ * then quantize to unorm16. Rounding error goes to the strongest influence
+ * so that the packed weights still sum exactly to 65535.
+ */
+void BoneStorageManager::PackVertex(const VertexBoneData& info)
 {
+	int order[MAX_NUM_BONES_PER_VERTEX];
+	for (int i = 0; i < info.index; ++i)
+		order[i] = i;
+
+	const int kept = std::min(info.index, influenceCount);
+
+	std::partial_sort(order, order + kept, order + info.index, [&info](int lhs, int rhs)
+		{
+			return info.Weights[lhs] > info.Weights[rhs];
+		});
+
+	float total = 0.f;
+	for (int i = 0; i < kept; ++i)
+		total += info.Weights[order[i]];
+
+	glm::u16 ids[MAX_PACKED_BONES_PER_VERTEX] = { 0 };
+	glm::u16 quantized[MAX_PACKED_BONES_PER_VERTEX] = { 0 };
 
+	if (total > 0.f)
+	{
+		int sum = 0;
+		for (int i = 0; i < kept; ++i)
+		{
+			const float normalized = info.Weights[order[i]] / total;
+
+			ids[i] = static_cast<glm::u16>(info.BoneIDs[order[i]]);
+			quantized[i] = static_cast<glm::u16>(std::lround(normalized * 65535.f));
+			sum += quantized[i];
+		}
+		quantized[0] = static_cast<glm::u16>(quantized[0] + (65535 - sum));
+	}
+
+	for (int group = 0; group < groupCount; ++group)
+	{
+		const int base = group * 4;
+		boneIds.emplace_back(ids[base], ids[base + 1], ids[base + 2], ids[base + 3]);
+		weights.emplace_back(quantized[base], quantized[base + 1], quantized[base + 2], quantized[base + 3]);
+	}
 }
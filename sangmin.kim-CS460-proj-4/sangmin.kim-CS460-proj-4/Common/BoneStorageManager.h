@@ -1,27 +1,36 @@
 /*
  * Author		: Ryan Kim.
  * Date			: 2022-10-07
- * Description	: Class for populate SSBOs of animating object.
+ * Description	: Class for pack bone ids / weights of animating object into vertex attributes.
+ *                Only the strongest influences of each vertex are kept (renormalized),
+ *                stored as groups of 4 (u16 ids, unorm16 weights).
  */
 
 
 #pragma once
 #include <vector>
+#include <glm/gtc/type_precision.hpp>
 #include "VertexBoneData.hpp"
 
 class BoneStorageManager
 {
 public:
-	BoneStorageManager(const std::vector<VertexBoneData>& boneInfos);
+	BoneStorageManager(const std::vector<VertexBoneData>& boneInfos,
+		int maxInfluences = DEFAULT_NUM_BONES_PER_VERTEX);
+	//Data already packed elsewhere (model cache), only counts are kept.
+	explicit BoneStorageManager(int maxInfluences);
 	~BoneStorageManager();
 
-	std::vector<int> bones;
-	std::vector<float> weights;
-	std::vector<int> indexStarts;
-	std::vector<int> indexEnds;
+	int GetInfluenceCount() const;
+	int GetGroupCount() const;
 
+	//groupCount entries per vertex
+	std::vector<glm::u16vec4> boneIds;
+	std::vector<glm::u16vec4> weights;
 
 private:
-	
+	void PackVertex(const VertexBoneData& info);
 
+	int influenceCount;
+	int groupCount;
 };
@@ -4,13 +4,14 @@
  * Description	: For handle OpenGL buffer
  */
 #pragma once
+#include <cstring>
 #include <vector>
 #include <GL/glew.h>
 
 class Buffer
 {
 public:
-	Buffer(GLenum type, unsigned size, GLenum usage, void* data);
+	Buffer(GLenum type, unsigned size, GLenum usage, const void* data);
 	void Bind(unsigned uniformBufferSlot = 0);
 	void BindStorage(int index);
 	void BindStorage();
@@ -21,6 +22,9 @@ public:
 
 	template <typename T>
 	void WriteData(void* data);
+
+	//writes first bytes only, buffer may be bigger than the data
+	void WriteRange(const void* data, unsigned bytes);
 	
 	unsigned GetId();
 	
@@ -89,6 +93,20 @@ void Buffer::WriteData(void* data)
 	glUnmapBuffer(type);
 }
 
+inline void Buffer::WriteRange(const void* data, unsigned bytes)
+{
+	if (bytes == 0)
+		return;
+
+	Bind();
+
+	void* writeVal = glMapBufferRange(type, 0, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+	memcpy(writeVal, data, bytes);
+	glUnmapBuffer(type);
+}
+
 template <typename T>
 std::vector<T> Buffer::Check()
 {
@@ -116,7 +134,7 @@ std::vector<T> Buffer::Check()
 	return check;
 }
 
-inline Buffer::Buffer(GLenum type, unsigned sizeVal, GLenum usage, void* data) : type(type)
+inline Buffer::Buffer(GLenum type, unsigned sizeVal, GLenum usage, const void* data) : type(type)
 {
 	storageIndex = 0;
 	size = sizeVal;
@@ -0,0 +1,266 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-11-07
+ * Description	: Catmull-Rom path through any number of control points.
+ */
+
+#include "CatmullRomPath.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+CatmullRomPath::CatmullRomPath(const std::vector<glm::vec3>& points_, bool closed_)
+	: points(points_), closed(closed_)
+{
+	const unsigned segmentCount = CalcSegmentCount();
+
+	segments.assign(segmentCount, CubicSpline(glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f)));
+	segmentTables.resize(segmentCount);
+
+	RebuildAround(0, static_cast<int>(segmentCount) - 1);
+}
+
+CatmullRomPath::~CatmullRomPath()
+= default;
+
+/*
+ * Closed path wraps around, open path repeats its end points.
+ */
+const glm::vec3& CatmullRomPath::ControlPoint(int index) const
+{
+	const int count = static_cast<int>(points.size());
+
+	if (closed)
+		return points[((index % count) + count) % count];
+
+	return points[std::min(std::max(index, 0), count - 1)];
+}
+
+unsigned CatmullRomPath::CalcSegmentCount() const
+{
+	if (points.size() < 2)
+		return 0;
+
+	return closed ? static_cast<unsigned>(points.size()) : static_cast<unsigned>(points.size()) - 1;
+}
+
+void CatmullRomPath::RebuildSegment(unsigned segment)
+{
+	const int i = static_cast<int>(segment);
+
+	segments[segment] = CubicSpline(ControlPoint(i - 1), ControlPoint(i), ControlPoint(i + 1), ControlPoint(i + 2));
+
+	std::vector<ArcLengthTableValue>& entries = segmentTables[segment];
+	entries.clear();
+	entries.push_back(ArcLengthTableValue{ 0.0, 0.0 });
+
+	ArcLengthTable::BuildEntries(segments[segment], lengthTolerance, maxSubdivisionDepth, entries);
+}
+
+/*
+ * Rebuild segments [firstSegment, lastSegment] (wrapped on closed path, clipped on open path),
+ * then the running length from the first rebuilt one.
+ */
+void CatmullRomPath::RebuildAround(int firstSegment, int lastSegment)
+{
+	const int count = static_cast<int>(segments.size());
+
+	segmentStarts.resize(segments.size() + 1);
+
+	lastEdit.firstSegment = 0;
+	lastEdit.lastSegment = -1;
+
+	if (count == 0)
+	{
+		segmentStarts[0] = 0.0;
+		return;
+	}
+
+	int prefixStart = count;
+
+	if (closed && lastSegment - firstSegment + 1 < count)
+	{
+		lastEdit.firstSegment = firstSegment;
+		lastEdit.lastSegment = lastSegment;
+
+		for(int i = firstSegment; i <= lastSegment; ++i)
+		{
+			const int segment = ((i % count) + count) % count;
+			RebuildSegment(static_cast<unsigned>(segment));
+			prefixStart = std::min(prefixStart, segment);
+		}
+	}
+	else
+	{
+		//open path clips, closed path covering every segment rebuilds all
+		firstSegment = closed ? 0 : std::max(firstSegment, 0);
+		lastSegment = closed ? count - 1 : std::min(lastSegment, count - 1);
+
+		for(int i = firstSegment; i <= lastSegment; ++i)
+			RebuildSegment(static_cast<unsigned>(i));
+
+		lastEdit.firstSegment = firstSegment;
+		lastEdit.lastSegment = lastSegment;
+		prefixStart = std::min(prefixStart, firstSegment);
+	}
+
+	segmentStarts[0] = 0.0;
+	for(int i = prefixStart; i < count; ++i)
+		segmentStarts[i + 1] = segmentStarts[i] + segmentTables[i].back().arcLength;
+}
+
+void CatmullRomPath::Insert(unsigned index, const glm::vec3& point)
+{
+	index = std::min(index, static_cast<unsigned>(points.size()));
+
+	points.insert(points.begin() + index, point);
+
+	//segments after the new point keep their shape, they only move up by one
+	const unsigned segmentCount = CalcSegmentCount();
+	lastEdit.slot = std::min(index, static_cast<unsigned>(segments.size()));
+	lastEdit.segmentChange = static_cast<int>(segmentCount) - static_cast<int>(segments.size());
+	while (segments.size() < segmentCount)
+	{
+		const unsigned slot = std::min(index, static_cast<unsigned>(segments.size()));
+
+		segments.insert(segments.begin() + slot, CubicSpline(point, point, point, point));
+		segmentTables.insert(segmentTables.begin() + slot, std::vector<ArcLengthTableValue>());
+	}
+
+	RebuildAround(static_cast<int>(index) - 2, static_cast<int>(index) + 1);
+}
+
+void CatmullRomPath::Remove(unsigned index)
+{
+	if (index >= points.size())
+		return;
+
+	points.erase(points.begin() + index);
+
+	const unsigned segmentCount = CalcSegmentCount();
+	lastEdit.slot = segments.empty() ? 0 : std::min(index, static_cast<unsigned>(segments.size()) - 1);
+	lastEdit.segmentChange = static_cast<int>(segmentCount) - static_cast<int>(segments.size());
+	while (segments.size() > segmentCount)
+	{
+		const unsigned slot = std::min(index, static_cast<unsigned>(segments.size()) - 1);
+
+		segments.erase(segments.begin() + slot);
+		segmentTables.erase(segmentTables.begin() + slot);
+	}
+
+	//segments that used the points on both sides of the removed one
+	RebuildAround(static_cast<int>(index) - 3, static_cast<int>(index) + 1);
+}
+
+void CatmullRomPath::Move(unsigned index, const glm::vec3& point)
+{
+	if (index >= points.size())
+		return;
+
+	points[index] = point;
+
+	lastEdit.slot = 0;
+	lastEdit.segmentChange = 0;
+	RebuildAround(static_cast<int>(index) - 2, static_cast<int>(index) + 1);
+}
+
+float CatmullRomPath::GetTotalLength() const
+{
+	return static_cast<float>(segmentStarts.back());
+}
+
+void CatmullRomPath::Locate(float distance, unsigned& segment, float& t) const
+{
+	segment = 0;
+	t = 0.f;
+
+	if (segments.empty())
+		return;
+
+	const double totalLength = segmentStarts.back();
+	double s = static_cast<double>(distance);
+
+	if (closed && totalLength > 0.0)
+	{
+		s = std::fmod(s, totalLength);
+		if (s < 0.0)
+			s += totalLength;
+	}
+	else
+		s = std::min(std::max(s, 0.0), totalLength);
+
+	const auto segmentIt = std::upper_bound(segmentStarts.begin() + 1, segmentStarts.end() - 1, s);
+	segment = static_cast<unsigned>(segmentIt - segmentStarts.begin()) - 1;
+
+	const std::vector<ArcLengthTableValue>& entries = segmentTables[segment];
+	const double localS = s - segmentStarts[segment];
+
+	const auto entryIt = std::upper_bound(entries.begin() + 1, entries.end() - 1, localS,
+		[](double value, const ArcLengthTableValue& entry) { return value < entry.arcLength; });
+
+	const ArcLengthTableValue& v0 = *(entryIt - 1);
+	const ArcLengthTableValue& v1 = *entryIt;
+
+	const double ds = v1.arcLength - v0.arcLength;
+	double localT = v0.parametric + (ds > 0.0 ? (localS - v0.arcLength) / ds : 0.0) * (v1.parametric - v0.parametric);
+
+	//few Newton steps, entry segments are short so it converges right away
+	const CubicSpline& spline = segments[segment];
+	for(int i = 0; i < 3; ++i)
+	{
+		const double speed = static_cast<double>(glm::length(spline.InterpolateDerivative(static_cast<float>(localT))));
+		if (speed <= 0.0)
+			break;
+
+		localT -= (v0.arcLength + ArcLengthTable::IntegrateLength(spline, v0.parametric, localT) - localS) / speed;
+		localT = std::min(std::max(localT, v0.parametric), v1.parametric);
+	}
+
+	t = static_cast<float>(localT);
+}
+
+glm::vec3 CatmullRomPath::GetPosition(float distance) const
+{
+	if (segments.empty())
+		return points.empty() ? glm::vec3(0.f) : points.front();
+
+	unsigned segment;
+	float t;
+	Locate(distance, segment, t);
+
+	return segments[segment].Interpolate(t);
+}
+
+glm::vec3 CatmullRomPath::GetTangent(float distance) const
+{
+	if (segments.empty())
+		return glm::vec3(0.f, 0.f, 1.f);
+
+	unsigned segment;
+	float t;
+	Locate(distance, segment, t);
+
+	const glm::vec3 derivative = segments[segment].InterpolateDerivative(t);
+	const float length = glm::length(derivative);
+
+	return length > 0.f ? derivative / length : glm::vec3(0.f, 0.f, 1.f);
+}
+
+void CatmullRomPath::Sample(unsigned count, std::vector<glm::vec3>& out) const
+{
+	out.clear();
+
+	if (count == 0)
+		return;
+
+	out.reserve(count);
+
+	const float totalLength = GetTotalLength();
+	const unsigned divisions = (closed || count == 1) ? count : count - 1;
+	const float spacing = totalLength / static_cast<float>(divisions);
+
+	for(unsigned i = 0; i < count; ++i)
+		out.push_back(GetPosition(spacing * static_cast<float>(i)));
+}
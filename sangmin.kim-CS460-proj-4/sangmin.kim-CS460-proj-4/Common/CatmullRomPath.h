@@ -0,0 +1,73 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-11-07
+ * Description	: Catmull-Rom path through any number of control points.
+ *                Segment i goes from point i to point i + 1, coefficients are kept
+ *                contiguous. Insert / Remove / Move rebuild only the (at most 4)
+ *                segments that use the edited point, then the running length.
+ */
+
+#pragma once
+#include <vector>
+#include "glm/vec3.hpp"
+
+#include "ArcLengthTable.h"
+#include "CubicSpline.h"
+
+class CatmullRomPath
+{
+public:
+	/*
+	 * What the last Insert / Remove / Move changed : segmentChange segments were added at slot
+	 * (taken out when < 0), then firstSegment..lastSegment were rebuilt (wrap them on closed path).
+	 */
+	struct EditRange
+	{
+		unsigned slot = 0;
+		int segmentChange = 0;
+		int firstSegment = 0;
+		int lastSegment = -1;
+	};
+
+	CatmullRomPath(const std::vector<glm::vec3>& points_, bool closed_);
+	~CatmullRomPath();
+
+	void Insert(unsigned index, const glm::vec3& point);
+	void Remove(unsigned index);
+	void Move(unsigned index, const glm::vec3& point);
+
+	unsigned GetPointCount() const { return static_cast<unsigned>(points.size()); }
+	unsigned GetSegmentCount() const { return static_cast<unsigned>(segments.size()); }
+	const glm::vec3& GetPoint(unsigned index) const { return points[index]; }
+	const CubicSpline& GetSegment(unsigned index) const { return segments[index]; }
+	bool IsClosed() const { return closed; }
+	const EditRange& GetLastEdit() const { return lastEdit; }
+
+	float GetTotalLength() const;
+	//distance along the path -> segment and local parameter
+	void Locate(float distance, unsigned& segment, float& t) const;
+	glm::vec3 GetPosition(float distance) const;
+	glm::vec3 GetTangent(float distance) const;
+	//count points evenly spaced in arc length, end point included for open path
+	void Sample(unsigned count, std::vector<glm::vec3>& out) const;
+
+	double lengthTolerance = 1e-4;
+	int maxSubdivisionDepth = 12;
+
+private:
+	const glm::vec3& ControlPoint(int index) const;
+	unsigned CalcSegmentCount() const;
+	void RebuildSegment(unsigned segment);
+	void RebuildAround(int firstSegment, int lastSegment);
+
+	std::vector<glm::vec3> points;
+	bool closed;
+
+	std::vector<CubicSpline> segments;
+	//per segment (local t, local s), entry 0 is (0, 0)
+	std::vector<std::vector<ArcLengthTableValue>> segmentTables;
+	//segmentStarts[i] : length of path before segment i, last one is total length
+	std::vector<double> segmentStarts;
+
+	EditRange lastEdit;
+};
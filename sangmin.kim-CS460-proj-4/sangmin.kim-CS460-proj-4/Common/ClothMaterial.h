@@ -0,0 +1,23 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Parameters shared by masses and springs of one cloth region.
+ *                Masses / springs keep the index only, so edits apply on the next step.
+ */
+
+#pragma once
+
+struct ClothMaterial
+{
+	float mass = 0.05f;
+	float springConstant = 1.f;
+	float dampingConstant = 0.05f;
+	//structural springs, shear springs use restLength * their restLengthScale
+	float restLength = 0.05f;
+};
+
+inline bool operator==(const ClothMaterial& a, const ClothMaterial& b)
+{
+	return a.mass == b.mass && a.springConstant == b.springConstant &&
+		a.dampingConstant == b.dampingConstant && a.restLength == b.restLength;
+}
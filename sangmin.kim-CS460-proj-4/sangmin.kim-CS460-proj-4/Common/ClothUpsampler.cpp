@@ -0,0 +1,220 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Fine render grid over a coarse simulated cloth grid.
+ */
+
+#include "ClothUpsampler.h"
+
+#include "Buffer.hpp"
+#include "Shader.h"
+#include "SimpleBox.h"
+
+ClothUpsampler::ClothUpsampler(Shader* dotShader_, Shader* lineShader_)
+{
+    dotShader = dotShader_;
+    lineShader = lineShader_;
+}
+
+ClothUpsampler::~ClothUpsampler()
+{
+    delete positionBuffer;
+    delete lineIndexBuffer;
+    glDeleteVertexArrays(1, &vao);
+}
+
+/*
+ * Segment i..i+1 at t uses i-1, i, i+1, i+2. Outside the grid the end point is mirrored
+ * (p[-1] = 2 p[0] - p[1]), folded into the weights of the two points it comes from.
+ */
+void ClothUpsampler::MakeTaps(int coarseCount, int refinement, std::vector<Taps>& taps)
+{
+    const int fineCount = (coarseCount - 1) * refinement + 1;
+    taps.resize(fineCount);
+
+    for (int f = 0; f < fineCount; ++f)
+    {
+        int segment = f / refinement;
+        float t = static_cast<float>(f % refinement) / static_cast<float>(refinement);
+        if (segment >= coarseCount - 1)
+        {
+            segment = coarseCount - 2;
+            t = 1.f;
+        }
+
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        const float w[4] =
+        {
+            0.5f * (-t3 + 2.f * t2 - t),
+            0.5f * (3.f * t3 - 5.f * t2 + 2.f),
+            0.5f * (-3.f * t3 + 4.f * t2 + t),
+            0.5f * (t3 - t2)
+        };
+
+        Taps& tap = taps[f];
+        for (int k = 0; k < 4; ++k)
+        {
+            tap.index[k] = segment - 1 + k;
+            tap.weight[k] = w[k];
+        }
+
+        if (tap.index[0] < 0)
+        {
+            tap.index[0] = 0;
+            tap.weight[1] += 2.f * w[0];
+            tap.weight[2] -= w[0];
+            tap.weight[0] = 0.f;
+        }
+        if (tap.index[3] > coarseCount - 1)
+        {
+            tap.index[3] = coarseCount - 1;
+            tap.weight[2] += 2.f * w[3];
+            tap.weight[1] -= w[3];
+            tap.weight[3] = 0.f;
+        }
+    }
+}
+
+void ClothUpsampler::Initialize(int coarseWidth_, int coarseHeight_, int refinement_)
+{
+    const bool sameSize = coarseWidth_ == coarseWidth && coarseHeight_ == coarseHeight && refinement_ == refinement;
+
+    coarseWidth = coarseWidth_;
+    coarseHeight = coarseHeight_;
+    refinement = refinement_ < 1 ? 1 : refinement_;
+
+    fineWidth = (coarseWidth - 1) * refinement + 1;
+    fineHeight = (coarseHeight - 1) * refinement + 1;
+
+    MakeTaps(coarseWidth, refinement, columnTaps);
+    MakeTaps(coarseHeight, refinement, rowTaps);
+
+    rowPositions.assign(static_cast<size_t>(coarseHeight) * fineWidth, glm::vec3(0.f));
+    finePositions.assign(static_cast<size_t>(fineWidth) * fineHeight, glm::vec3(0.f));
+
+    if (!sameSize || vao == 0)
+        UploadTopology();
+}
+
+void ClothUpsampler::UploadTopology()
+{
+    std::vector<unsigned> indices;
+    indices.reserve(static_cast<size_t>(fineWidth) * fineHeight * 4);
+
+    for (int y = 0; y < fineHeight; ++y)
+    {
+        for (int x = 0; x < fineWidth; ++x)
+        {
+            const unsigned index = y * fineWidth + x;
+
+            if (x + 1 < fineWidth)
+            {
+                indices.push_back(index);
+                indices.push_back(index + 1);
+            }
+            if (y + 1 < fineHeight)
+            {
+                indices.push_back(index);
+                indices.push_back(index + fineWidth);
+            }
+        }
+    }
+
+    lineIndexCount = static_cast<unsigned>(indices.size());
+
+    if (vao == 0)
+        glGenVertexArrays(1, &vao);
+
+    delete positionBuffer;
+    delete lineIndexBuffer;
+
+    glBindVertexArray(vao);
+
+    positionBuffer = new Buffer(GL_ARRAY_BUFFER, static_cast<unsigned>(sizeof(glm::vec3) * finePositions.size()),
+        GL_DYNAMIC_DRAW, finePositions.data());
+    positionBuffer->Bind();
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<GLvoid*>(0));
+
+    lineIndexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<unsigned>(sizeof(unsigned) * indices.size()),
+        GL_STATIC_DRAW, indices.data());
+
+    glBindVertexArray(0);
+}
+
+void ClothUpsampler::Upsample(const float* px, const float* py, const float* pz)
+{
+    //along x on every coarse row
+    for (int y = 0; y < coarseHeight; ++y)
+    {
+        const int rowStart = y * coarseWidth;
+        glm::vec3* out = rowPositions.data() + static_cast<size_t>(y) * fineWidth;
+
+        for (int x = 0; x < fineWidth; ++x)
+        {
+            const Taps& tap = columnTaps[x];
+
+            glm::vec3 position(0.f);
+            for (int k = 0; k < 4; ++k)
+            {
+                const int i = rowStart + tap.index[k];
+                position += tap.weight[k] * glm::vec3(px[i], py[i], pz[i]);
+            }
+            out[x] = position;
+        }
+    }
+
+    //then along y between those rows
+    for (int y = 0; y < fineHeight; ++y)
+    {
+        const Taps& tap = rowTaps[y];
+        const glm::vec3* rows[4];
+        for (int k = 0; k < 4; ++k)
+            rows[k] = rowPositions.data() + static_cast<size_t>(tap.index[k]) * fineWidth;
+
+        glm::vec3* out = finePositions.data() + static_cast<size_t>(y) * fineWidth;
+        for (int x = 0; x < fineWidth; ++x)
+        {
+            out[x] = tap.weight[0] * rows[0][x] + tap.weight[1] * rows[1][x] +
+                tap.weight[2] * rows[2][x] + tap.weight[3] * rows[3][x];
+        }
+    }
+}
+
+void ClothUpsampler::ResolveBox(const SimpleBox* box)
+{
+    //same extents as PointMass::CheckCollisionWithBox
+    const glm::vec3 boxHalfScale = (box->scale / 2.f) + glm::vec3(0.2f);
+    const glm::vec3 boxMin = box->pos - boxHalfScale;
+    const glm::vec3 boxMax = box->pos + boxHalfScale;
+
+    for (glm::vec3& position : finePositions)
+    {
+        if (position.x >= boxMin.x && position.x <= boxMax.x &&
+            position.z >= boxMin.z && position.z <= boxMax.z &&
+            position.y <= boxMax.y && position.y >= boxMin.y)
+        {
+            position.y = boxMax.y;
+        }
+    }
+}
+
+void ClothUpsampler::Draw(glm::mat4 projViewMat)
+{
+    if (vao == 0)
+        return;
+
+    glBindVertexArray(vao);
+    positionBuffer->WriteRange(finePositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * finePositions.size()));
+
+    dotShader->Use();
+    dotShader->SendUniformMatGLM("projViewModelMat", projViewMat);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(finePositions.size()));
+
+    lineShader->Use();
+    lineShader->SendUniformMatGLM("gWVP", projViewMat);
+    glDrawElements(GL_LINES, static_cast<GLsizei>(lineIndexCount), GL_UNSIGNED_INT, static_cast<GLvoid*>(0));
+
+    glBindVertexArray(0);
+}
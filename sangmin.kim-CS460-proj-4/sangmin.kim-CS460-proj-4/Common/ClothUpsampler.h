@@ -0,0 +1,64 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Fine render grid over a coarse simulated cloth grid.
+ *                Fine positions are a Catmull-Rom surface through the coarse masses,
+ *                evaluated as two 4-tap passes (rows, then columns) with weights made once.
+ *                Local detail on the fine level only : vertices pushed out of the box.
+ */
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+class Buffer;
+class Shader;
+class SimpleBox;
+
+class ClothUpsampler
+{
+public:
+    ClothUpsampler(Shader* dotShader_, Shader* lineShader_);
+    ~ClothUpsampler();
+
+    //fine grid of (coarseWidth - 1) * refinement + 1 by (coarseHeight - 1) * refinement + 1
+    void Initialize(int coarseWidth_, int coarseHeight_, int refinement_);
+    //coarse positions as separate arrays, index = y * coarseWidth + x
+    void Upsample(const float* px, const float* py, const float* pz);
+    //fine vertices inside the box go to its top, the coarse grid only touches it at masses
+    void ResolveBox(const SimpleBox* box);
+    void Draw(glm::mat4 projViewMat);
+
+    int GetFineWidth() const { return fineWidth; }
+    int GetFineHeight() const { return fineHeight; }
+    glm::vec3 GetFinePosition(int index) const { return finePositions[index]; }
+
+private:
+    //coarse neighbours and Catmull-Rom weights of one fine column (or row)
+    struct Taps
+    {
+        int index[4];
+        float weight[4];
+    };
+
+    static void MakeTaps(int coarseCount, int refinement, std::vector<Taps>& taps);
+    void UploadTopology();
+
+    int coarseWidth = 0, coarseHeight = 0;
+    int refinement = 1;
+    int fineWidth = 0, fineHeight = 0;
+
+    std::vector<Taps> columnTaps;
+    std::vector<Taps> rowTaps;
+    //after the row pass : coarseHeight rows of fineWidth
+    std::vector<glm::vec3> rowPositions;
+    std::vector<glm::vec3> finePositions;
+
+    Shader* dotShader;
+    Shader* lineShader;
+
+    unsigned vao = 0;
+    Buffer* positionBuffer = nullptr;
+    Buffer* lineIndexBuffer = nullptr;
+    unsigned lineIndexCount = 0;
+};
@@ -0,0 +1,271 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Many independent grid cloths (flags, curtains, capes) in one place.
+ */
+
+#include "ClothWorld.h"
+
+#include <algorithm>
+
+#include "Buffer.hpp"
+#include "GridCloth.h"
+#include "JobSystem.h"
+#include "Shader.h"
+#include "SimpleBox.h"
+
+ClothWorld::ClothWorld(Shader* dotShader_, Shader* lineShader_, JobSystem* jobSystem_)
+{
+    dotShader = dotShader_;
+    lineShader = lineShader_;
+    jobSystem = jobSystem_;
+}
+
+ClothWorld::~ClothWorld()
+{
+    delete positionBuffer;
+    delete lineIndexBuffer;
+    glDeleteVertexArrays(1, &vao);
+}
+
+unsigned ClothWorld::AddCloth(int width, int height, glm::vec3 origin, glm::vec3 xStep, glm::vec3 yStep,
+    const ClothMaterial& material)
+{
+    Cloth cloth;
+    cloth.first = static_cast<unsigned>(px.size());
+    cloth.firstRow = static_cast<unsigned>(rowMaterials.size());
+    cloth.width = width;
+    cloth.height = height;
+
+    const unsigned id = static_cast<unsigned>(cloths.size());
+    cloths.push_back(cloth);
+
+    materials.push_back(material);
+    rowMaterials.insert(rowMaterials.end(), height, id);
+
+    //no reserve : pools keep growing geometrically over many AddCloth calls
+    const size_t count = px.size() + static_cast<size_t>(width) * height;
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const glm::vec3 position = origin + xStep * static_cast<float>(x) + yStep * static_cast<float>(y);
+
+            px.push_back(position.x);
+            py.push_back(position.y);
+            pz.push_back(position.z);
+            drawPositions.push_back(position);
+        }
+    }
+
+    vx.resize(count, 0.f);
+    vy.resize(count, 0.f);
+    vz.resize(count, 0.f);
+    fixedMasses.resize(count, 0);
+
+    stepOrder.push_back(id);
+
+    orderDirty = true;
+    topologyDirty = true;
+    return id;
+}
+
+void ClothWorld::Clear()
+{
+    cloths.clear();
+    stepOrder.clear();
+
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz };
+    for (std::vector<float>* a : arrays)
+        a->clear();
+    fixedMasses.clear();
+    drawPositions.clear();
+    materials.clear();
+    rowMaterials.clear();
+
+    topologyDirty = true;
+}
+
+unsigned ClothWorld::MassIndex(unsigned cloth, int x, int y) const
+{
+    return cloths[cloth].first + static_cast<unsigned>(y * cloths[cloth].width + x);
+}
+
+void ClothWorld::StepCloth(unsigned cloth, float dt, const SimpleBox* box)
+{
+    const Cloth& currCloth = cloths[cloth];
+    const unsigned first = currCloth.first;
+
+    GridStepContext c;
+    c.px = px.data() + first; c.py = py.data() + first; c.pz = pz.data() + first;
+    c.vx = vx.data() + first; c.vy = vy.data() + first; c.vz = vz.data() + first;
+    c.fixedMasses = fixedMasses.data() + first;
+    c.materials = materials.data();
+    c.rowMaterials = rowMaterials.data() + currCloth.firstRow;
+    c.massScale = 1.f;
+    c.restLengthScaleX = 1.f;
+    c.restLengthScaleY = 1.f;
+    c.width = currCloth.width;
+    c.height = currCloth.height;
+    c.dt = dt;
+    c.gravity = gravity;
+
+    if (box)
+    {
+        const glm::vec3 boxHalfScale = (box->scale / 2.f) + glm::vec3(0.2f);
+        c.boxMinX = box->pos.x - boxHalfScale.x;
+        c.boxMaxX = box->pos.x + boxHalfScale.x;
+        c.boxMinZ = box->pos.z - boxHalfScale.z;
+        c.boxMaxZ = box->pos.z + boxHalfScale.z;
+        c.boxTop = box->pos.y + boxHalfScale.y;
+    }
+    else
+    {
+        c.boxMinX = c.boxMinZ = 1.f;
+        c.boxMaxX = c.boxMaxZ = -1.f;
+        c.boxTop = 0.f;
+    }
+
+    StepGridRows(c, 0, currCloth.height);
+
+    const unsigned last = first + static_cast<unsigned>(currCloth.width * currCloth.height);
+    for (unsigned i = first; i < last; ++i)
+        drawPositions[i] = glm::vec3(px[i], py[i], pz[i]);
+}
+
+void ClothWorld::Update(float dt, SimpleBox* box)
+{
+    if (cloths.empty() || dt <= 0.f)
+        return;
+
+    //sorted once after a batch of AddCloth, not on every call
+    if (orderDirty)
+    {
+        std::stable_sort(stepOrder.begin(), stepOrder.end(), [this](unsigned a, unsigned b)
+        {
+            return cloths[a].width * cloths[a].height > cloths[b].width * cloths[b].height;
+        });
+        orderDirty = false;
+    }
+
+    const unsigned clothCount = static_cast<unsigned>(cloths.size());
+
+    //cloths share no masses, each one is a job of its own
+    auto job = [this, dt, box](unsigned i)
+    {
+        StepCloth(stepOrder[i], dt, box);
+    };
+
+    if (jobSystem)
+        jobSystem->ParallelFor(clothCount, job);
+    else
+    {
+        for (unsigned i = 0; i < clothCount; ++i)
+            job(i);
+    }
+}
+
+/*
+ * Lines of every cloth in one index buffer, indices offset by where the cloth starts in the pools.
+ */
+void ClothWorld::UploadTopology()
+{
+    std::vector<unsigned> indices;
+
+    for (const Cloth& cloth : cloths)
+    {
+        for (int y = 0; y < cloth.height - 1; ++y)
+        {
+            for (int x = 0; x < cloth.width - 1; ++x)
+            {
+                const unsigned index = cloth.first + y * cloth.width + x;
+                const unsigned right = index + 1;
+                const unsigned down = index + cloth.width;
+                const unsigned downRight = down + 1;
+
+                const unsigned cell[8] = { index, right, index, down, index, downRight, right, down };
+                indices.insert(indices.end(), cell, cell + 8);
+            }
+        }
+    }
+
+    lineIndexCount = static_cast<unsigned>(indices.size());
+
+    if (vao == 0)
+        glGenVertexArrays(1, &vao);
+
+    delete positionBuffer;
+    delete lineIndexBuffer;
+
+    glBindVertexArray(vao);
+
+    positionBuffer = new Buffer(GL_ARRAY_BUFFER, static_cast<unsigned>(sizeof(glm::vec3) * drawPositions.size()),
+        GL_DYNAMIC_DRAW, drawPositions.data());
+    positionBuffer->Bind();
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<GLvoid*>(0));
+
+    lineIndexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<unsigned>(sizeof(unsigned) * indices.size()),
+        GL_STATIC_DRAW, indices.data());
+
+    glBindVertexArray(0);
+
+    topologyDirty = false;
+}
+
+void ClothWorld::Draw(glm::mat4 projViewMat)
+{
+    if (cloths.empty())
+        return;
+
+    //new buffers already hold the positions
+    const bool upload = !topologyDirty;
+    if (topologyDirty)
+        UploadTopology();
+
+    glBindVertexArray(vao);
+    if (upload)
+        positionBuffer->WriteRange(drawPositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * drawPositions.size()));
+
+    dotShader->Use();
+    dotShader->SendUniformMatGLM("projViewModelMat", projViewMat);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(drawPositions.size()));
+
+    lineShader->Use();
+    lineShader->SendUniformMatGLM("gWVP", projViewMat);
+    glDrawElements(GL_LINES, static_cast<GLsizei>(lineIndexCount), GL_UNSIGNED_INT, static_cast<GLvoid*>(0));
+
+    glBindVertexArray(0);
+}
+
+void ClothWorld::SetFixed(unsigned cloth, int x, int y, bool fixed)
+{
+    fixedMasses[MassIndex(cloth, x, y)] = fixed ? 1 : 0;
+}
+
+void ClothWorld::SetPosition(unsigned cloth, int x, int y, glm::vec3 position)
+{
+    const unsigned i = MassIndex(cloth, x, y);
+
+    px[i] = position.x;
+    py[i] = position.y;
+    pz[i] = position.z;
+    drawPositions[i] = position;
+}
+
+glm::vec3 ClothWorld::GetPosition(unsigned cloth, int x, int y) const
+{
+    const unsigned i = MassIndex(cloth, x, y);
+    return glm::vec3(px[i], py[i], pz[i]);
+}
+
+ClothMaterial ClothWorld::GetMaterial(unsigned cloth) const
+{
+    return materials[cloth];
+}
+
+void ClothWorld::SetMaterial(unsigned cloth, const ClothMaterial& material)
+{
+    materials[cloth] = material;
+}
@@ -0,0 +1,90 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Many independent grid cloths (flags, curtains, capes) in one place.
+ *                State of every cloth is a slice of shared pools, one Update steps all of them
+ *                with the GridCloth kernel as jobs (largest cloths first), one Draw draws all
+ *                of them with a single points and a single lines call.
+ */
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "ClothMaterial.h"
+
+class Buffer;
+class JobSystem;
+class Shader;
+class SimpleBox;
+
+class ClothWorld
+{
+public:
+    //jobSystem_ optional, without it cloths are stepped on the calling thread
+    ClothWorld(Shader* dotShader_, Shader* lineShader_, JobSystem* jobSystem_ = nullptr);
+    ~ClothWorld();
+
+    /*
+     * width x height masses at origin + x * xStep + y * yStep, so any orientation works
+     * (yStep down for a hanging flag). Returns the cloth id, ids stay valid until Clear.
+     */
+    unsigned AddCloth(int width, int height, glm::vec3 origin, glm::vec3 xStep, glm::vec3 yStep,
+        const ClothMaterial& material);
+    void Clear();
+
+    //box may be null
+    void Update(float dt, SimpleBox* box);
+    void Draw(glm::mat4 projViewMat);
+
+    void SetFixed(unsigned cloth, int x, int y, bool fixed);
+    //anchors following something else (pole, shoulders)
+    void SetPosition(unsigned cloth, int x, int y, glm::vec3 position);
+    glm::vec3 GetPosition(unsigned cloth, int x, int y) const;
+    //by value : AddCloth may move the materials, edits go through SetMaterial and apply on the next Update
+    ClothMaterial GetMaterial(unsigned cloth) const;
+    void SetMaterial(unsigned cloth, const ClothMaterial& material);
+
+    unsigned GetClothCount() const { return static_cast<unsigned>(cloths.size()); }
+    unsigned GetMassCount() const { return static_cast<unsigned>(px.size()); }
+
+    float gravity = -9.81f;
+
+private:
+    struct Cloth
+    {
+        //first mass in the pools
+        unsigned first;
+        //first entry in rowMaterials
+        unsigned firstRow;
+        int width;
+        int height;
+    };
+
+    unsigned MassIndex(unsigned cloth, int x, int y) const;
+    void StepCloth(unsigned cloth, float dt, const SimpleBox* box);
+    void UploadTopology();
+
+    JobSystem* jobSystem;
+    Shader* dotShader;
+    Shader* lineShader;
+
+    std::vector<Cloth> cloths;
+    //cloth ids by mass count, largest first : big jobs start early, small ones fill the gaps
+    std::vector<unsigned> stepOrder;
+    bool orderDirty = false;
+
+    //pools, one entry per mass of every cloth
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<unsigned char> fixedMasses;
+    std::vector<glm::vec3> drawPositions;
+    //one material per cloth, every row of a cloth points at it
+    std::vector<ClothMaterial> materials;
+    std::vector<unsigned> rowMaterials;
+
+    bool topologyDirty = true;
+    unsigned vao = 0;
+    Buffer* positionBuffer = nullptr;
+    Buffer* lineIndexBuffer = nullptr;
+    unsigned lineIndexCount = 0;
+};
@@ -0,0 +1,349 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Compressed form of one animation clip.
+ */
+
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <assimp/anim.h>
+#include <glm/geometric.hpp>
+
+#include "PoseBlending.h"
+
+namespace
+{
+	const float invSqrt2 = 0.70710678f;
+	const float maxU15 = 32767.f;
+	const float maxU16 = 65535.f;
+
+	glm::vec3 ToVec3(const aiVector3D& value)
+	{
+		return glm::vec3(value.x, value.y, value.z);
+	}
+
+	/*
+	 * Greedy key reduction : extend segment from last kept key while every skipped key
+	 * is reproduced by interpolation within tolerance.
+	 */
+	template <typename T, typename Interpolate, typename Error>
+	std::vector<unsigned> ReduceKeys(const std::vector<float>& times, const std::vector<T>& values,
+		float tolerance, Interpolate interpolate, Error error)
+	{
+		const unsigned size = static_cast<unsigned>(values.size());
+		std::vector<unsigned> kept;
+
+		if (size <= 2)
+		{
+			for (unsigned i = 0; i < size; ++i)
+				kept.push_back(i);
+			return kept;
+		}
+
+		kept.push_back(0);
+		unsigned anchor = 0;
+
+		for (unsigned end = 2; end < size; ++end)
+		{
+			const float span = times[end] - times[anchor];
+
+			for (unsigned k = anchor + 1; k < end; ++k)
+			{
+				const float factor = span > 0.f ? (times[k] - times[anchor]) / span : 0.f;
+
+				if (error(interpolate(values[anchor], values[end], factor), values[k]) > tolerance)
+				{
+					anchor = end - 1;
+					kept.push_back(anchor);
+					break;
+				}
+			}
+		}
+
+		kept.push_back(size - 1);
+
+		//constant track : one key is enough
+		if (kept.size() == 2 && error(values[0], values[size - 1]) <= tolerance)
+			kept.pop_back();
+
+		return kept;
+	}
+
+	QuantizedKey QuantizeRotation(glm::vec4 q)
+	{
+		int largest = 0;
+		for (int i = 1; i < 4; ++i)
+		{
+			if (std::abs(q[i]) > std::abs(q[largest]))
+				largest = i;
+		}
+
+		if (q[largest] < 0.f)
+			q = -q;
+
+		glm::u16 values[3];
+		int slot = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+
+			const float normalized = glm::clamp(q[i] / invSqrt2 * 0.5f + 0.5f, 0.f, 1.f);
+			values[slot++] = static_cast<glm::u16>(std::lround(normalized * maxU15));
+		}
+
+		QuantizedKey key;
+		key.values[0] = static_cast<glm::u16>(values[0] | ((largest & 1) << 15));
+		key.values[1] = static_cast<glm::u16>(values[1] | ((largest >> 1) << 15));
+		key.values[2] = values[2];
+
+		return key;
+	}
+
+	glm::vec4 DequantizeRotation(const QuantizedKey& key)
+	{
+		const int largest = (key.values[0] >> 15) | ((key.values[1] >> 15) << 1);
+
+		glm::vec4 q;
+		float sum = 0.f;
+		int slot = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+
+			const float normalized = static_cast<float>(key.values[slot++] & 0x7FFF) / maxU15;
+			q[i] = (normalized * 2.f - 1.f) * invSqrt2;
+			sum += q[i] * q[i];
+		}
+		q[largest] = std::sqrt(std::max(0.f, 1.f - sum));
+
+		return q;
+	}
+
+	QuantizedKey QuantizeVector(const glm::vec3& value, const glm::vec3& min, const glm::vec3& extent)
+	{
+		QuantizedKey key;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float normalized = extent[i] > 0.f ? (value[i] - min[i]) / extent[i] : 0.f;
+			key.values[i] = static_cast<glm::u16>(std::lround(glm::clamp(normalized, 0.f, 1.f) * maxU16));
+		}
+		return key;
+	}
+
+	glm::vec4 DequantizeVector(const QuantizedKey& key, const glm::vec3& min, const glm::vec3& extent)
+	{
+		return glm::vec4(
+			min.x + extent.x * (key.values[0] / maxU16),
+			min.y + extent.y * (key.values[1] / maxU16),
+			min.z + extent.z * (key.values[2] / maxU16),
+			0.f);
+	}
+
+	float RotationError(const glm::vec4& a, const glm::vec4& b)
+	{
+		const float dot = std::min(std::abs(glm::dot(a, b)), 1.f);
+		return 2.f * std::acos(dot);
+	}
+}
+
+CompressedClip::CompressedClip(const aiAnimation* animation, const std::vector<const aiNodeAnim*>& channels,
+	const ClipCompressionSettings& settings)
+{
+	durationTicks = static_cast<float>(animation->mDuration);
+
+	const size_t nodeCount = channels.size();
+	trackIndices.resize(nodeCount, -1);
+
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		if (!channels[i])
+			continue;
+
+		trackIndices[i] = static_cast<int>(tracks.size());
+		AddTrack(channels[i], settings);
+	}
+}
+
+CompressedClip::~CompressedClip()
+{
+}
+
+bool CompressedClip::HasTrack(unsigned node) const
+{
+	return trackIndices[node] >= 0;
+}
+
+void CompressedClip::SampleNode(unsigned node, float animationTimeTicks,
+	glm::vec4& rotation, glm::vec4& translation, glm::vec4& scale) const
+{
+	const CompressedTrack& track = tracks[trackIndices[node]];
+	const float quantizedTime = durationTicks > 0.f ? animationTimeTicks / durationTicks * maxU16 : 0.f;
+
+	auto factorBetween = [quantizedTime](glm::u16 t1, glm::u16 t2)
+	{
+		return t2 > t1 ? glm::clamp((quantizedTime - t1) / static_cast<float>(t2 - t1), 0.f, 1.f) : 0.f;
+	};
+
+	if (track.rotationCount > 0)
+	{
+		const unsigned key = FindKey(rotationTimes, track.rotationFirst, track.rotationCount, quantizedTime);
+		const glm::vec4 start = DequantizeRotation(rotationKeys[key]);
+
+		if (key + 1 < track.rotationFirst + track.rotationCount)
+			rotation = PoseBlending::Nlerp(start, DequantizeRotation(rotationKeys[key + 1]),
+				factorBetween(rotationTimes[key], rotationTimes[key + 1]));
+		else
+			rotation = start;
+	}
+
+	if (track.translationCount > 0)
+	{
+		const unsigned key = FindKey(translationTimes, track.translationFirst, track.translationCount, quantizedTime);
+		const glm::vec4 start = DequantizeVector(translationKeys[key], track.translationMin, track.translationExtent);
+
+		if (key + 1 < track.translationFirst + track.translationCount)
+		{
+			const glm::vec4 end = DequantizeVector(translationKeys[key + 1], track.translationMin, track.translationExtent);
+			translation = start + (end - start) * factorBetween(translationTimes[key], translationTimes[key + 1]);
+		}
+		else
+			translation = start;
+	}
+
+	if (track.scaleCount > 0)
+	{
+		const unsigned key = FindKey(scaleTimes, track.scaleFirst, track.scaleCount, quantizedTime);
+		const glm::vec4 start = DequantizeVector(scaleKeys[key], track.scaleMin, track.scaleExtent);
+
+		if (key + 1 < track.scaleFirst + track.scaleCount)
+		{
+			const glm::vec4 end = DequantizeVector(scaleKeys[key + 1], track.scaleMin, track.scaleExtent);
+			scale = start + (end - start) * factorBetween(scaleTimes[key], scaleTimes[key + 1]);
+		}
+		else
+			scale = start;
+	}
+}
+
+size_t CompressedClip::GetMemory() const
+{
+	return sizeof(int) * trackIndices.size() + sizeof(CompressedTrack) * tracks.size()
+		+ sizeof(glm::u16) * (rotationTimes.size() + translationTimes.size() + scaleTimes.size())
+		+ sizeof(QuantizedKey) * (rotationKeys.size() + translationKeys.size() + scaleKeys.size());
+}
+
+size_t CompressedClip::GetRawMemory() const
+{
+	return rawMemory;
+}
+
+void CompressedClip::AddTrack(const aiNodeAnim* nodeAnim, const ClipCompressionSettings& settings)
+{
+	CompressedTrack track{};
+
+	rawMemory += sizeof(aiQuatKey) * nodeAnim->mNumRotationKeys
+		+ sizeof(aiVectorKey) * (nodeAnim->mNumPositionKeys + nodeAnim->mNumScalingKeys);
+
+	//Rotations
+	{
+		std::vector<float> times(nodeAnim->mNumRotationKeys);
+		std::vector<glm::vec4> values(nodeAnim->mNumRotationKeys);
+
+		for (unsigned i = 0; i < nodeAnim->mNumRotationKeys; ++i)
+		{
+			const aiQuatKey& key = nodeAnim->mRotationKeys[i];
+			times[i] = static_cast<float>(key.mTime);
+			values[i] = glm::normalize(glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w));
+
+			//keep neighbours in same hemisphere so interpolation takes short path
+			if (i > 0 && glm::dot(values[i - 1], values[i]) < 0.f)
+				values[i] = -values[i];
+		}
+
+		const std::vector<unsigned> kept = ReduceKeys(times, values, settings.rotationError,
+			PoseBlending::Nlerp, RotationError);
+
+		track.rotationFirst = static_cast<unsigned>(rotationKeys.size());
+		track.rotationCount = static_cast<unsigned>(kept.size());
+		for (unsigned index : kept)
+		{
+			rotationTimes.push_back(QuantizeTime(times[index]));
+			rotationKeys.push_back(QuantizeRotation(values[index]));
+		}
+	}
+
+	//Translations, scales
+	auto addVectorTrack = [this](const aiVectorKey* keys, unsigned count, float tolerance,
+		std::vector<glm::u16>& outTimes, std::vector<QuantizedKey>& outKeys,
+		unsigned& first, unsigned& keptCount, glm::vec3& min, glm::vec3& extent)
+	{
+		std::vector<float> times(count);
+		std::vector<glm::vec3> values(count);
+
+		glm::vec3 max(-FLT_MAX);
+		min = glm::vec3(FLT_MAX);
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			times[i] = static_cast<float>(keys[i].mTime);
+			values[i] = ToVec3(keys[i].mValue);
+			min = glm::min(min, values[i]);
+			max = glm::max(max, values[i]);
+		}
+		extent = count > 0 ? max - min : glm::vec3(0.f);
+
+		const std::vector<unsigned> kept = ReduceKeys(times, values, tolerance,
+			[](const glm::vec3& a, const glm::vec3& b, float factor) { return a + (b - a) * factor; },
+			[](const glm::vec3& a, const glm::vec3& b) { return glm::distance(a, b); });
+
+		first = static_cast<unsigned>(outKeys.size());
+		keptCount = static_cast<unsigned>(kept.size());
+		for (unsigned index : kept)
+		{
+			outTimes.push_back(QuantizeTime(times[index]));
+			outKeys.push_back(QuantizeVector(values[index], min, extent));
+		}
+	};
+
+	addVectorTrack(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys, settings.translationError,
+		translationTimes, translationKeys, track.translationFirst, track.translationCount,
+		track.translationMin, track.translationExtent);
+
+	addVectorTrack(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys, settings.scaleError,
+		scaleTimes, scaleKeys, track.scaleFirst, track.scaleCount,
+		track.scaleMin, track.scaleExtent);
+
+	tracks.push_back(track);
+}
+
+glm::u16 CompressedClip::QuantizeTime(double time) const
+{
+	if (durationTicks <= 0.f)
+		return 0;
+
+	const float normalized = glm::clamp(static_cast<float>(time) / durationTicks, 0.f, 1.f);
+	return static_cast<glm::u16>(std::lround(normalized * maxU16));
+}
+
+/*
+ * Binary search for last key whose time <= quantizedTime.
+ */
+unsigned CompressedClip::FindKey(const std::vector<glm::u16>& times, unsigned first, unsigned count,
+	float quantizedTime) const
+{
+	const auto begin = times.begin() + first;
+	const auto end = begin + count;
+
+	const auto upper = std::upper_bound(begin, end, quantizedTime,
+		[](float value, glm::u16 keyTime) { return value < static_cast<float>(keyTime); });
+
+	if (upper == begin)
+		return first;
+
+	return static_cast<unsigned>((upper - times.begin()) - 1);
+}
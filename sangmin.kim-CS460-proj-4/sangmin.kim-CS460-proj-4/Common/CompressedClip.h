@@ -0,0 +1,79 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Compressed form of one animation clip.
+ *                Keys which can be interpolated from neighbours within error bound are removed,
+ *                rotations are stored as smallest-three (3 x 15 bits + 2 bits index),
+ *                translations / scales are quantized to 16 bits inside per track range,
+ *                key times are 16 bits normalized over clip duration.
+ *                Decompression happens while sampling.
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+struct aiAnimation;
+struct aiNodeAnim;
+
+struct ClipCompressionSettings
+{
+	float rotationError = 0.001f;		//radians
+	float translationError = 0.001f;	//model units
+	float scaleError = 0.001f;
+};
+
+struct QuantizedKey
+{
+	glm::u16 values[3];
+};
+
+struct CompressedTrack
+{
+	unsigned rotationFirst, rotationCount;
+	unsigned translationFirst, translationCount;
+	unsigned scaleFirst, scaleCount;
+	glm::vec3 translationMin, translationExtent;
+	glm::vec3 scaleMin, scaleExtent;
+};
+
+class CompressedClip
+{
+public:
+	//channels : per node, nullptr if node is not animated
+	CompressedClip(const aiAnimation* animation, const std::vector<const aiNodeAnim*>& channels,
+		const ClipCompressionSettings& settings);
+	~CompressedClip();
+
+	bool HasTrack(unsigned node) const;
+	//channels without keys leave their output untouched, caller fills it with the bind pose first
+	void SampleNode(unsigned node, float animationTimeTicks,
+		glm::vec4& rotation, glm::vec4& translation, glm::vec4& scale) const;
+
+	size_t GetMemory() const;
+	size_t GetRawMemory() const;
+
+private:
+	friend class ModelCache;
+	CompressedClip() = default;
+
+	void AddTrack(const aiNodeAnim* nodeAnim, const ClipCompressionSettings& settings);
+	glm::u16 QuantizeTime(double time) const;
+	unsigned FindKey(const std::vector<glm::u16>& times, unsigned first, unsigned count, float quantizedTime) const;
+
+	float durationTicks = 0.f;
+	size_t rawMemory = 0;
+
+	std::vector<int> trackIndices;
+	std::vector<CompressedTrack> tracks;
+
+	std::vector<glm::u16> rotationTimes;
+	std::vector<QuantizedKey> rotationKeys;
+	std::vector<glm::u16> translationTimes;
+	std::vector<QuantizedKey> translationKeys;
+	std::vector<glm::u16> scaleTimes;
+	std::vector<QuantizedKey> scaleKeys;
+};
@@ -12,8 +12,8 @@ class CubicSpline
 public:
 	CubicSpline(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3);
 	~CubicSpline();
-	glm::vec3 Interpolate(float t);
-	glm::vec3 InterpolateDerivative(float t);
+	glm::vec3 Interpolate(float t) const;
+	glm::vec3 InterpolateDerivative(float t) const;
 private:
 	glm::vec3 a, b, c, d;
 };
@@ -30,13 +30,13 @@ inline CubicSpline::~CubicSpline()
 {
 }
 
-inline glm::vec3 CubicSpline::Interpolate(float t)
+inline glm::vec3 CubicSpline::Interpolate(float t) const
 {
 	glm::vec3 result = (a * (t * t * t)) + (b * (t * t)) + (c * (t)) + d;
 	return result;
 }
 
-inline glm::vec3 CubicSpline::InterpolateDerivative(float t)
+inline glm::vec3 CubicSpline::InterpolateDerivative(float t) const
 {
 	glm::vec3 result = (3.f * a * (t * t)) + (2.f * b * (t)) + c;
 	return result;
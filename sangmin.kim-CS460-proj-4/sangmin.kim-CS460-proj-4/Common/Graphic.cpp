@@ -11,29 +11,39 @@
 #include "Shader.h"
 #include "Camera.hpp"
 #include <GLFW/glfw3.h>
+#include "AnimationBlender.h"
 #include "AnimationModel.h"
+#include "BakedCrowd.h"
 #include "Object.h"
 #include <fstream>
 
 #include "Buffer.hpp"
+#include "ClothWorld.h"
+#include "JobSystem.h"
 #include "Line.h"
+#include "PathAgents.h"
 #include "PhysicsSimulation.h"
 #include "Pointmass.h"
+#include "PoseEvaluator.h"
 #include "SimpleBox.h"
 #include "Skybox.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 
 Graphic::Graphic() : windowWidth(128 * 10), windowHeight(128 * 6), deltaTime(0.f), lastFrame(0.f)
 {
 	std::cout << "Graphic()" << std::endl;
+	jobSystem = new JobSystem();
+	assetLoader = new AssetLoader(jobSystem);
+
 	shader = new Shader("../Shaders/vert.glsl", "../Shaders/frag.glsl");
 	lineShader = new Shader("../Shaders/lineVert.glsl", "../Shaders/lineFrag.glsl");
 	floorShader = new Shader("../Shaders/floorVertex.glsl", "../Shaders/floorFragment.glsl");
 	dotsShader = new Shader("../Shaders/SimpleVert.glsl", "../Shaders/SimpleFrag.glsl");
+	bakedShader = new Shader("../Shaders/bakedVert.glsl", "../Shaders/frag.glsl");
 
-	boxTexture = new Texture(GL_TEXTURE_2D,	"../Models/container.jpg");
-	boxTexture->Load();
+	boxTexture = assetLoader->LoadTexture("../Models/container.jpg");
 
 	cam = new Camera(glm::vec3(8.99861f, 16.0555f, 43.1732f), 
 		glm::vec3(0.0372666f, 0.906928f, -0.419634f),
@@ -48,7 +58,8 @@ Graphic::Graphic() : windowWidth(128 * 10), windowHeight(128 * 6), deltaTime(0.f
 	animationIndex = 0;
 	showOthers = false;
 	skybox = new SkyBox();
-	physicsSimulation = new PhysicsSimulation(dotsShader, lineShader);
+	poseEvaluator = new PoseEvaluator(jobSystem);
+	physicsSimulation = new PhysicsSimulation(dotsShader, lineShader, jobSystem);
 
 	simpleBox = new SimpleBox(floorShader);
 	frontRight = new SimpleBox(floorShader);
@@ -62,26 +73,62 @@ Graphic::~Graphic()
 {
 	delete shader;
 	delete lineShader;
+	delete bakedShader;
 	delete cam;
 	delete line;
 	delete skybox;
 	delete physicsSimulation;
+	delete clothWorld;
 	delete simpleBox;
 	delete frontLeft;
 	delete frontRight;
 	delete backLeft;
 	delete backRight;
+	delete poseEvaluator;
+	delete assetLoader;
+	TextureCache::Get().Clear();
+	delete jobSystem;
 }
 
+/*
+ * Background cloths : flags on poles (left column fixed) and curtains (top row fixed)
+ * of mixed sizes, all in one ClothWorld.
+ */
 void Graphic::Populate()
 {
-
+	clothWorld = new ClothWorld(dotsShader, lineShader, jobSystem);
+
+	ClothMaterial material;
+	const float spacing = 0.2f;
+
+	for (int i = 0; i < 24; ++i)
+	{
+		const int width = 8 + (i % 4) * 4;
+		const int height = 6 + (i % 3) * 3;
+		const glm::vec3 origin(-30.f + static_cast<float>(i) * 4.f, 14.f, -15.f);
+
+		const unsigned cloth = clothWorld->AddCloth(width, height, origin,
+			glm::vec3(spacing, 0.f, 0.f), glm::vec3(0.f, -spacing, 0.f), material);
+
+		if (i % 2 == 0)
+		{
+			for (int y = 0; y < height; ++y)
+				clothWorld->SetFixed(cloth, 0, y, true);
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+				clothWorld->SetFixed(cloth, x, 0, true);
+		}
+	}
 }
 
 
 
 void Graphic::Draw(float dt)
 {
+	assetLoader->PumpUploads(uploadBudgetMilliseconds);
+
 	glClearColor(0.5f, .5f, .5f, 1.f);
 	glEnable(GL_DEPTH_TEST);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -96,14 +143,59 @@ void Graphic::Draw(float dt)
 
 	physicsSimulation->UpdateSimulation(dt, simpleBox);
 	physicsSimulation->Draw(projViewMat);
-	simpleBox->Draw(projViewMat, boxTexture);
+	simpleBox->Draw(projViewMat, boxTexture.Get());
 
 	physicsSimulation->SetAnchorPositions(frontLeft->pos, backLeft->pos, frontRight->pos, backRight->pos);
 
-	frontRight->Draw(projViewMat, boxTexture);
-	backRight->Draw(projViewMat, boxTexture);
-	frontLeft->Draw(projViewMat, boxTexture);
-	backLeft->Draw(projViewMat, boxTexture);
+	if (showClothWorld)
+	{
+		clothWorld->Update(dt, simpleBox);
+		clothWorld->Draw(projViewMat);
+	}
+
+	frontRight->Draw(projViewMat, boxTexture.Get());
+	backRight->Draw(projViewMat, boxTexture.Get());
+	frontLeft->Draw(projViewMat, boxTexture.Get());
+	backLeft->Draw(projViewMat, boxTexture.Get());
+
+	DrawAnimatedObjects(projViewMat);
+
+	const float crowdTime = std::chrono::duration<float>(std::chrono::system_clock::now() - startTime).count();
+	for (BakedCrowd* crowd : bakedCrowds)
+		crowd->Draw(projViewMat, crowdTime);
+}
+
+/*
+ * Sample every instance's pose in parallel first,
+ * then issue draws with the evaluated bone transforms.
+ */
+void Graphic::DrawAnimatedObjects(const glm::mat4& projViewMat)
+{
+	if (animatedObjects.empty())
+		return;
+
+	const auto now = std::chrono::system_clock::now();
+	const size_t objectsSize = animatedObjects.size();
+
+	std::vector<float> animationTs(objectsSize);
+
+	poseEvaluator->BeginFrame();
+	for (size_t i = 0; i < objectsSize; ++i)
+	{
+		Object* object = animatedObjects[i];
+		animationTs[i] = std::chrono::duration<float>(now - object->GetAnimationStartTime()).count();
+		object->blender->Update(deltaTime);
+		poseEvaluator->Request(object->animationModel, object->blender, animationTs[i]);
+	}
+
+	poseEvaluator->Evaluate();
+
+	for (size_t i = 0; i < objectsSize; ++i)
+	{
+		const unsigned request = static_cast<unsigned>(i);
+		animatedObjects[i]->DrawPose(projViewMat, animationTs[i], transformsOffset,
+			poseEvaluator->GetTransforms(request), poseEvaluator->GetTransformsCount(request));
+	}
 }
 
 void Graphic::DrawLine(glm::mat4 projViewMat_)
@@ -134,19 +226,33 @@ void Graphic::ProcessInput()
 		cam->ProcessKeyboard(BACKWARD, deltaTime);
 
 	if (glfwGetKey(window, GLFW_KEY_1))
-		animationIndex = 0;
+		ChangeAnimation(0);
 	if (glfwGetKey(window, GLFW_KEY_2))
-		animationIndex = 1;
+		ChangeAnimation(1);
 	if (glfwGetKey(window, GLFW_KEY_3))
-		animationIndex = 2;
+		ChangeAnimation(2);
 	if (glfwGetKey(window, GLFW_KEY_4))
-		animationIndex = 3;
+		ChangeAnimation(3);
 
 
 	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
 		camLock = !camLock;
 }
 
+/*
+ * Cross fade every animating object to new clip instead of snapping.
+ */
+void Graphic::ChangeAnimation(unsigned index)
+{
+	if (index == animationIndex)
+		return;
+
+	animationIndex = index;
+
+	for (Object* object : animatedObjects)
+		object->blender->CrossFade(index, crossFadeDuration);
+}
+
 void Graphic::InitLineBuffer()
 {
 	lineCoords = line->Coords();
@@ -167,19 +273,7 @@ void Graphic::InitLineBuffer()
 
 float Graphic::DistanceTimeFunction(float t) const
 {
-	float s;
-
-	const float f = k1 * 2.f / PI + k2 - k1 + (1.f - k2) * 2.f / PI;
-
-	if (t < k1) 
-		s = k1 * (2.f / PI) * (sin(t / k1 * PI / 2.f - PI / 2.f) + 1.f);
-	else if (t < k2) 
-		s = 2.f * k1 / PI + t - k1;
-	else 
-		s = 2.f * k1 / PI + k2 - k1 + ((1.f - k2) * (2.f / PI)) * 
-		sin((t - k2) / (1.f - k2) * PI / 2.f);
-
-	return s / f;
+	return PathAgents::EaseDistance(t, k1, k2);
 }
 
 void Graphic::Reset()
@@ -12,11 +12,14 @@
 #include <glm/detail/type_mat.hpp>
 #include <glm/detail/type_vec.hpp>
 
+#include "AssetLoader.h"
+
 
 class SkyBox;
 class Texture;
 class SimpleBox;
 class PhysicsSimulation;
+class ClothWorld;
 class Floor;
 class Buffer;
 class Line;
@@ -25,7 +28,10 @@ struct aiScene;
 class Camera;
 class GLFWwindow;
 class AnimationModel;
+class BakedCrowd;
 class Object;
+class JobSystem;
+class PoseEvaluator;
 
 const static std::string bobLampPath = "../Models/boblampclean.md5mesh";
 const static std::string hellKnightPath = "../Models/hellknight/hellknight.md5mesh";
@@ -45,14 +51,16 @@ public:
 	void Populate();
 	void Draw(float dt);
 	void DrawLine(glm::mat4 projViewMat_);
+	void DrawAnimatedObjects(const glm::mat4& projViewMat);
 	void ProcessInput();
+	void ChangeAnimation(unsigned index);
 	void InitLineBuffer();
 	float DistanceTimeFunction(float t) const;
 	void Reset();
 	float t1 = 0.2f;
 	float t2 = 0.8f;
 	float t3 = 1.f;
-	Texture* boxTexture;
+	AssetHandle<Texture> boxTexture;
 	GLFWwindow* window;
 	Camera* cam;
 	AnimationModel* mutant;
@@ -62,9 +70,19 @@ public:
 	AnimationModel* multipleAni;
 	SkyBox* skybox;
 
+	JobSystem* jobSystem;
+	AssetLoader* assetLoader;
+	float uploadBudgetMilliseconds = 2.f;
+	PoseEvaluator* poseEvaluator;
+	std::vector<Object*> animatedObjects;
+	std::vector<BakedCrowd*> bakedCrowds;
+
 	std::vector<glm::mat4> totalTransform;
 	std::vector<int> offsets;
 	PhysicsSimulation* physicsSimulation;
+	//many small cloths stepped and drawn as one batch
+	ClothWorld* clothWorld;
+	bool showClothWorld = false;
 	void ReInitSimulation();
 
 	float deltaTime, lastFrame;
@@ -72,6 +90,7 @@ public:
 
 	int transformsOffset;
 	unsigned animationIndex;
+	float crossFadeDuration = 0.3f;
 	bool showOthers;
 	Object* obj;
 	Line* line;
@@ -91,6 +110,7 @@ private:
 	Shader* lineShader;
 	Shader* floorShader;
 	Shader* dotsShader;
+	Shader* bakedShader;
 	Floor* floor;
 	const int windowWidth;
 	const int windowHeight;
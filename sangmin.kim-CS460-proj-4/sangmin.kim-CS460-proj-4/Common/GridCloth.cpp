@@ -0,0 +1,603 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Cloth on a regular grid without Spring objects.
+ */
+
+#include "GridCloth.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Buffer.hpp"
+#include "Pointmass.h"
+#include "Shader.h"
+#include "SimpleBox.h"
+
+namespace
+{
+    /*
+     * Same forces and integration as PointMass::update, in place and in the same
+     * row-major order, so masses already done this step are seen by later ones as before.
+     * Checked == false is for masses whose every stencil neighbour is inside the grid.
+     */
+    template <class Stencil, bool Checked>
+    inline void StepMass(const GridStepContext& c, const float* restScales, int w, int x, int y)
+    {
+        const int i = y * w + x;
+
+        const float pX = c.px[i], pY = c.py[i], pZ = c.pz[i];
+        const float vX = c.vx[i], vY = c.vy[i], vZ = c.vz[i];
+
+        const bool inBox = pX >= c.boxMinX && pX <= c.boxMaxX &&
+            pZ >= c.boxMinZ && pZ <= c.boxMaxZ && pY <= c.boxTop;
+
+        if (c.fixedMasses[i] || inBox)
+            return;
+
+        const float mass = c.materials[c.rowMaterials[y]].mass * c.massScale;
+
+        float fX = 0.f;
+        float fY = c.gravity * (mass / 2.f);
+        float fZ = 0.f;
+
+        for (int s = 0; s < Stencil::count; ++s)
+        {
+            const int dx = Stencil::Dx(s);
+            const int dy = Stencil::Dy(s);
+
+            if (Checked && (x + dx < 0 || x + dx >= w || y + dy < 0 || y + dy >= c.height))
+                continue;
+
+            const int j = i + dy * w + dx;
+
+            const float dX = c.px[j] - pX;
+            const float dY = c.py[j] - pY;
+            const float dZ = c.pz[j] - pZ;
+            const float length = std::sqrt(dX * dX + dY * dY + dZ * dZ);
+
+            if (length <= 0.f)
+                continue;
+
+            const float invLength = 1.f / length;
+            const float nX = dX * invLength, nY = dY * invLength, nZ = dZ * invLength;
+
+            //spring belongs to the upper of the two rows, as when springs were built per cell
+            const ClothMaterial& material = c.materials[c.rowMaterials[dy < 0 ? y + dy : y]];
+
+            const float hooksLaw = 0.5f * material.springConstant * (length - material.restLength * restScales[s]);
+            const float damping = -material.dampingConstant * c.massScale *
+                (nX * (vX + c.vx[j]) + nY * (vY + c.vy[j]) + nZ * (vZ + c.vz[j]));
+
+            const float f = hooksLaw + damping;
+            fX += f * nX;
+            fY += f * nY;
+            fZ += f * nZ;
+        }
+
+        const float invMass = 1.f / mass;
+        const float dt = c.dt;
+
+        const float velX = rungeKutta(vX, vX + fX * invMass * dt, dt);
+        const float velY = rungeKutta(vY, vY + fY * invMass * dt, dt);
+        const float velZ = rungeKutta(vZ, vZ + fZ * invMass * dt, dt);
+
+        c.vx[i] = velX; c.vy[i] = velY; c.vz[i] = velZ;
+        c.px[i] = pX + velX * dt;
+        c.py[i] = pY + velY * dt;
+        c.pz[i] = pZ + velZ * dt;
+    }
+
+    template <int Width, class Stencil>
+    void StepRow(const GridStepContext& c, const float* restScales, int y)
+    {
+        //Width == 0 : any width, known only at run time
+        const int w = Width > 0 ? Width : c.width;
+
+        if (y == 0 || y == c.height - 1 || w < 3)
+        {
+            for (int x = 0; x < w; ++x)
+                StepMass<Stencil, true>(c, restScales, w, x, y);
+            return;
+        }
+
+        StepMass<Stencil, true>(c, restScales, w, 0, y);
+        for (int x = 1; x < w - 1; ++x)
+            StepMass<Stencil, false>(c, restScales, w, x, y);
+        StepMass<Stencil, true>(c, restScales, w, w - 1, y);
+    }
+
+    template <int Width, class Stencil>
+    void StepRows(const GridStepContext& c, int firstRow, int lastRow)
+    {
+        //once per call, not per spring
+        float restScales[Stencil::count];
+        for (int s = 0; s < Stencil::count; ++s)
+            restScales[s] = Stencil::RestScale(s, c.restLengthScaleX, c.restLengthScaleY);
+
+        for (int y = firstRow; y < lastRow; ++y)
+            StepRow<Width, Stencil>(c, restScales, y);
+    }
+
+    typedef void (*StepRowsFunction)(const GridStepContext&, int, int);
+
+    template <class Stencil>
+    StepRowsFunction SelectKernel(int width)
+    {
+        switch (width)
+        {
+        case 32:  return &StepRows<32, Stencil>;
+        case 50:  return &StepRows<50, Stencil>;
+        case 64:  return &StepRows<64, Stencil>;
+        case 75:  return &StepRows<75, Stencil>;
+        case 100: return &StepRows<100, Stencil>;
+        case 128: return &StepRows<128, Stencil>;
+        default:  return &StepRows<0, Stencil>;
+        }
+    }
+}
+
+void StepGridRows(const GridStepContext& c, int firstRow, int lastRow)
+{
+    const StepRowsFunction kernel = SelectKernel<StructuralShearStencil>(c.width);
+    kernel(c, firstRow, lastRow);
+}
+
+GridCloth::GridCloth(Shader* dotShader_, Shader* lineShader_)
+{
+    dotShader = dotShader_;
+    lineShader = lineShader_;
+}
+
+GridCloth::~GridCloth()
+{
+    delete positionBuffer;
+    delete lineIndexBuffer;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GridCloth::Initialize(int width_, int height_, glm::vec3 leftBack, float xStep, float zStep)
+{
+    const bool sameSize = width_ == width && height_ == height;
+
+    width = width_;
+    height = height_;
+
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz };
+    for (std::vector<float>* a : arrays)
+        a->assign(count, 0.f);
+
+    fixedMasses.assign(count, 0);
+    drawPositions.resize(count);
+
+    if (rowMaterials.size() != static_cast<size_t>(height))
+        rowMaterials.assign(height, 0);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+
+            px[i] = leftBack.x + xStep * static_cast<float>(x);
+            py[i] = leftBack.y;
+            pz[i] = leftBack.z + zStep * static_cast<float>(y);
+
+            drawPositions[i] = glm::vec3(px[i], py[i], pz[i]);
+        }
+    }
+
+    if (!sameSize || vao == 0)
+        UploadTopology();
+    else
+        positionBuffer->WriteRange(drawPositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * count));
+    positionsDirty = false;
+
+    //neighbouring bands share the springs between their edge rows
+    const unsigned tileCount = static_cast<unsigned>((height + rowsPerTile - 1) / rowsPerTile);
+
+    sleepTiles.Reset(tileCount);
+    for (unsigned tile = 1; tile < tileCount; ++tile)
+        sleepTiles.AddNeighbours(tile - 1, tile);
+    sleepTiles.FinishNeighbours();
+
+    /*
+     * Stencil springs with fixed colours : springs of one kind only share a mass with
+     * the next one along x (or y for down springs), so parity of x (y) separates them.
+     */
+    const float diagonal = std::sqrt(xStep * xStep + zStep * zStep);
+
+    strainLimiter.Reset(static_cast<unsigned>(count));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+
+            if (x + 1 < width)
+                strainLimiter.AddConstraint(i, i + 1, std::abs(xStep), x % 2);
+            if (y + 1 < height)
+                strainLimiter.AddConstraint(i, i + width, std::abs(zStep), 2 + y % 2);
+            if (x + 1 < width && y + 1 < height)
+            {
+                strainLimiter.AddConstraint(i, i + width + 1, diagonal, 4 + x % 2);
+                strainLimiter.AddConstraint(i + 1, i + width, diagonal, 6 + x % 2);
+            }
+        }
+    }
+}
+
+/*
+ * Lines for the same springs the explicit cloth draws, as indices into the position buffer.
+ */
+void GridCloth::UploadTopology()
+{
+    std::vector<unsigned> indices;
+    indices.reserve(static_cast<size_t>(width > 0 ? width - 1 : 0) * (height > 0 ? height - 1 : 0) * 8);
+
+    for (int y = 0; y < height - 1; ++y)
+    {
+        for (int x = 0; x < width - 1; ++x)
+        {
+            const unsigned index = y * width + x;
+            const unsigned right = index + 1;
+            const unsigned down = index + width;
+            const unsigned downRight = down + 1;
+
+            const unsigned cell[8] = { index, right, index, down, index, downRight, right, down };
+            indices.insert(indices.end(), cell, cell + 8);
+        }
+    }
+
+    lineIndexCount = static_cast<unsigned>(indices.size());
+
+    if (vao == 0)
+        glGenVertexArrays(1, &vao);
+
+    delete positionBuffer;
+    delete lineIndexBuffer;
+
+    glBindVertexArray(vao);
+
+    positionBuffer = new Buffer(GL_ARRAY_BUFFER, static_cast<unsigned>(sizeof(glm::vec3) * drawPositions.size()),
+        GL_DYNAMIC_DRAW, drawPositions.data());
+    positionBuffer->Bind();
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<GLvoid*>(0));
+
+    lineIndexBuffer = new Buffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<unsigned>(sizeof(unsigned) * indices.size()),
+        GL_STATIC_DRAW, indices.data());
+
+    glBindVertexArray(0);
+}
+
+void GridCloth::Update(float dt, SimpleBox* box)
+{
+    if (width == 0 || height == 0 || dt <= 0.f)
+        return;
+
+    sleepTiles.WakeOnChange(box, materials);
+
+    const glm::vec3 boxHalfScale = (box->scale / 2.f) + glm::vec3(0.2f);
+
+    GridStepContext c;
+    c.px = px.data(); c.py = py.data(); c.pz = pz.data();
+    c.vx = vx.data(); c.vy = vy.data(); c.vz = vz.data();
+    c.fixedMasses = fixedMasses.data();
+    c.materials = materials.data();
+    c.rowMaterials = rowMaterials.data();
+    c.massScale = massScale;
+    c.restLengthScaleX = restLengthScaleX;
+    c.restLengthScaleY = restLengthScaleZ;
+    c.width = width;
+    c.height = height;
+    c.dt = dt;
+    c.gravity = -9.81f;
+    c.boxMinX = box->pos.x - boxHalfScale.x;
+    c.boxMaxX = box->pos.x + boxHalfScale.x;
+    c.boxMinZ = box->pos.z - boxHalfScale.z;
+    c.boxMaxZ = box->pos.z + boxHalfScale.z;
+    c.boxTop = box->pos.y + boxHalfScale.y;
+
+    const StepRowsFunction kernel = SelectKernel<StructuralShearStencil>(width);
+    const unsigned tileCount = sleepTiles.GetTileCount();
+    const float invDt = 1.f / dt;
+
+    //bands in order, so awake bands see the same neighbours as one pass over all rows
+    for (unsigned tile = 0; tile < tileCount; ++tile)
+    {
+        if (!sleepTiles.IsAwake(tile))
+            continue;
+
+        const int firstRow = static_cast<int>(tile) * rowsPerTile;
+        const int lastRow = std::min(firstRow + rowsPerTile, height);
+
+        kernel(c, firstRow, lastRow);
+
+        //energy from how far masses really moved, colliding masses keep their velocity
+        float maxEnergy = 0.f;
+        for (int y = firstRow; y < lastRow; ++y)
+        {
+            const float mass = materials[rowMaterials[y]].mass * massScale;
+
+            for (int i = y * width; i < (y + 1) * width; ++i)
+            {
+                const glm::vec3 position(px[i], py[i], pz[i]);
+                const glm::vec3 velocity = (position - drawPositions[i]) * invDt;
+
+                maxEnergy = std::max(maxEnergy, 0.5f * mass * glm::dot(velocity, velocity));
+                drawPositions[i] = position;
+            }
+        }
+
+        if (sleepTiles.EndStep(tile, maxEnergy))
+        {
+            const size_t first = static_cast<size_t>(firstRow) * width;
+            const size_t last = static_cast<size_t>(lastRow) * width;
+
+            std::fill(vx.begin() + first, vx.begin() + last, 0.f);
+            std::fill(vy.begin() + first, vy.begin() + last, 0.f);
+            std::fill(vz.begin() + first, vz.begin() + last, 0.f);
+        }
+
+        positionsDirty = true;
+    }
+
+    sleepTiles.PropagateWakes();
+}
+
+void GridCloth::LimitStrain(float dt, float maxStretch, int iterations, JobSystem* jobSystem)
+{
+    const size_t count = px.size();
+
+    inverseMasses.resize(count);
+    for (int y = 0; y < height; ++y)
+    {
+        const float inverseMass = 1.f / (materials[rowMaterials[y]].mass * massScale);
+
+        for (int i = y * width; i < (y + 1) * width; ++i)
+            inverseMasses[i] = fixedMasses[i] ? 0.f : inverseMass;
+    }
+
+    if (!strainLimiter.Project(px.data(), py.data(), pz.data(), vx.data(), vy.data(), vz.data(),
+        inverseMasses.data(), maxStretch, iterations, dt, jobSystem))
+        return;
+
+    //sleeping masses pulled by a neighbour band wake up
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 position(px[i], py[i], pz[i]);
+        if (position == drawPositions[i])
+            continue;
+
+        drawPositions[i] = position;
+        sleepTiles.Wake(static_cast<unsigned>(i / width / rowsPerTile));
+    }
+
+    positionsDirty = true;
+}
+
+void GridCloth::Draw(glm::mat4 projViewMat)
+{
+    if (vao == 0)
+        return;
+
+    glBindVertexArray(vao);
+    if (positionsDirty)
+        positionBuffer->WriteRange(drawPositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * drawPositions.size()));
+    positionsDirty = false;
+
+    dotShader->Use();
+    dotShader->SendUniformMatGLM("projViewModelMat", projViewMat);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(drawPositions.size()));
+
+    lineShader->Use();
+    lineShader->SendUniformMatGLM("gWVP", projViewMat);
+    glDrawElements(GL_LINES, static_cast<GLsizei>(lineIndexCount), GL_UNSIGNED_INT, static_cast<GLvoid*>(0));
+
+    glBindVertexArray(0);
+}
+
+void GridCloth::SetResolutionScale(float xScale, float zScale)
+{
+    massScale = xScale * zScale;
+    restLengthScaleX = xScale;
+    restLengthScaleZ = zScale;
+}
+
+bool GridCloth::SetPosition(int index, glm::vec3 position)
+{
+    if (GetPosition(index) == position)
+        return false;
+
+    px[index] = position.x;
+    py[index] = position.y;
+    pz[index] = position.z;
+    drawPositions[index] = position;
+
+    sleepTiles.Wake(static_cast<unsigned>(index / width / rowsPerTile));
+    positionsDirty = true;
+    return true;
+}
+
+glm::vec3 GridCloth::GetPosition(int index) const
+{
+    return glm::vec3(px[index], py[index], pz[index]);
+}
+
+void GridCloth::SetFixed(int index, bool fixed)
+{
+    const unsigned char value = fixed ? 1 : 0;
+    if (fixedMasses[index] == value)
+        return;
+
+    fixedMasses[index] = value;
+    sleepTiles.Wake(static_cast<unsigned>(index / width / rowsPerTile));
+}
+
+void GridCloth::SetAllFixed(bool fixed)
+{
+    fixedMasses.assign(fixedMasses.size(), fixed ? 1 : 0);
+    sleepTiles.WakeAll();
+}
+
+void GridCloth::GetTileMasses(unsigned tile, size_t& first, size_t& last) const
+{
+    const int firstRow = static_cast<int>(tile) * rowsPerTile;
+    const int lastRow = std::min(firstRow + rowsPerTile, height);
+
+    first = static_cast<size_t>(firstRow) * width;
+    last = static_cast<size_t>(lastRow) * width;
+}
+
+void GridCloth::SaveState(const std::vector<unsigned>& tiles, ClothSnapshot& snapshot) const
+{
+    const size_t count = px.size();
+
+    snapshot.positions.resize(count);
+    snapshot.velocities.resize(count);
+    sleepTiles.GetCalmSteps(snapshot.calmSteps);
+
+    for (unsigned tile : tiles)
+    {
+        size_t first, last;
+        GetTileMasses(tile, first, last);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            snapshot.positions[i] = glm::vec3(px[i], py[i], pz[i]);
+            snapshot.velocities[i] = glm::vec3(vx[i], vy[i], vz[i]);
+        }
+    }
+}
+
+void GridCloth::RestoreState(const std::vector<unsigned>& tiles, const ClothSnapshot& snapshot, bool keepVelocities)
+{
+    for (unsigned tile : tiles)
+    {
+        size_t first, last;
+        GetTileMasses(tile, first, last);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            const glm::vec3& position = snapshot.positions[i];
+            const glm::vec3 velocity = keepVelocities ? snapshot.velocities[i] : glm::vec3(0.f);
+
+            px[i] = position.x; py[i] = position.y; pz[i] = position.z;
+            vx[i] = velocity.x; vy[i] = velocity.y; vz[i] = velocity.z;
+            drawPositions[i] = position;
+        }
+    }
+
+    sleepTiles.SetCalmSteps(snapshot.calmSteps);
+    positionsDirty = true;
+}
+
+void GridCloth::GetSpringLengths(std::vector<float>& lengths, std::vector<float>& restLengths) const
+{
+    lengths.clear();
+    restLengths.clear();
+
+    //same springs as UploadTopology : right, down, down right, right -> down
+    const float restScales[4] =
+    {
+        StructuralShearStencil::RestScale(0, restLengthScaleX, restLengthScaleZ),
+        StructuralShearStencil::RestScale(2, restLengthScaleX, restLengthScaleZ),
+        StructuralShearStencil::RestScale(4, restLengthScaleX, restLengthScaleZ),
+        StructuralShearStencil::RestScale(4, restLengthScaleX, restLengthScaleZ)
+    };
+
+    for (int y = 0; y < height - 1; ++y)
+    {
+        const float restLength = materials[rowMaterials[y]].restLength;
+
+        for (int x = 0; x < width - 1; ++x)
+        {
+            const int index = y * width + x;
+            const int right = index + 1;
+            const int down = index + width;
+            const int downRight = down + 1;
+
+            const int ends[8] = { index, right, index, down, index, downRight, right, down };
+            for (int s = 0; s < 4; ++s)
+            {
+                lengths.push_back(glm::length(GetPosition(ends[s * 2 + 1]) - GetPosition(ends[s * 2])));
+                restLengths.push_back(restLength * restScales[s]);
+            }
+        }
+    }
+}
+
+/*
+ * Springs of cell row y join rows y and y + 1, so a band also owns the cell row above it.
+ */
+void GridCloth::GetTileSprings(const std::vector<unsigned>& tiles, std::vector<unsigned>& springIndices) const
+{
+    springIndices.clear();
+
+    const unsigned cellsPerRow = static_cast<unsigned>(width - 1);
+
+    for (unsigned tile : tiles)
+    {
+        const int firstRow = std::max(static_cast<int>(tile) * rowsPerTile - 1, 0);
+        const int lastRow = std::min(static_cast<int>(tile + 1) * rowsPerTile, height - 1);
+
+        for (int y = firstRow; y < lastRow; ++y)
+        {
+            const unsigned first = static_cast<unsigned>(y) * cellsPerRow * 4;
+            const unsigned last = first + cellsPerRow * 4;
+
+            for (unsigned i = first; i < last; ++i)
+                springIndices.push_back(i);
+        }
+    }
+}
+
+void GridCloth::GetSpringLengths(const std::vector<unsigned>& springIndices, std::vector<float>& lengths) const
+{
+    const unsigned cellsPerRow = static_cast<unsigned>(width - 1);
+
+    for (unsigned spring : springIndices)
+    {
+        const unsigned cell = spring / 4;
+        const int index = static_cast<int>((cell / cellsPerRow) * width + cell % cellsPerRow);
+        const int right = index + 1;
+        const int down = index + width;
+        const int downRight = down + 1;
+
+        const int ends[8] = { index, right, index, down, index, downRight, right, down };
+        const unsigned s = spring % 4;
+
+        lengths[spring] = glm::length(GetPosition(ends[s * 2 + 1]) - GetPosition(ends[s * 2]));
+    }
+}
+
+void GridCloth::GetStiffnessRatios(float& stiffnessToMass, float& dampingToMass) const
+{
+    stiffnessToMass = 0.f;
+    dampingToMass = 0.f;
+
+    //masses of one row all see the same materials, edge rows just have fewer springs
+    for (int y = 0; y < height; ++y)
+    {
+        float stiffness = 0.f;
+        float damping = 0.f;
+
+        for (int s = 0; s < StructuralShearStencil::count; ++s)
+        {
+            const int dy = StructuralShearStencil::Dy(s);
+            if (y + dy < 0 || y + dy >= height)
+                continue;
+
+            const ClothMaterial& material = materials[rowMaterials[dy < 0 ? y + dy : y]];
+            stiffness += 0.5f * material.springConstant;
+            damping += material.dampingConstant * massScale;
+        }
+
+        const float mass = materials[rowMaterials[y]].mass * massScale;
+        stiffnessToMass = std::max(stiffnessToMass, stiffness / mass);
+        dampingToMass = std::max(dampingToMass, damping / mass);
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Cloth on a regular grid without Spring objects.
+ *                Neighbours come from (x, y) stencil offsets, state is kept as separate
+ *                float arrays and the step kernel is a template on grid width and stencil,
+ *                so common widths get constant row offsets and unrolled stencil loops.
+ *                Masses are updated in place in row-major order like MassSpringSystem.
+ *                Bands of rowsPerTile rows are the sleeping tiles.
+ */
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "glm/glm.hpp"
+#include "ClothMaterial.h"
+#include "SleepTiles.h"
+#include "StrainLimiter.h"
+
+class Buffer;
+class JobSystem;
+class Shader;
+class SimpleBox;
+
+/*
+ * Springs InitializeSimulation used to create per cell : right, down (structural),
+ * down right and right -> down (shear). Seen from one mass that is all 8 neighbours.
+ */
+struct StructuralShearStencil
+{
+    static const int count = 8;
+
+    static int Dx(int i)
+    {
+        const int dx[count] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+        return dx[i];
+    }
+    static int Dy(int i)
+    {
+        const int dy[count] = { 0, 0, 1, -1, 1, -1, -1, 1 };
+        return dy[i];
+    }
+    //times material rest length, grid spacing scaled by scaleX along x and scaleY along y
+    static float RestScale(int i, float scaleX, float scaleY)
+    {
+        if (i < 4)
+            return Dx(i) != 0 ? scaleX : scaleY;
+        return 1.4142f * std::sqrt(0.5f * (scaleX * scaleX + scaleY * scaleY));
+    }
+};
+
+/*
+ * Arrays and constants of one grid for the step kernel, index = y * width + x.
+ * GridCloth fills it from its own arrays, ClothWorld from a slice of its pools.
+ */
+struct GridStepContext
+{
+    float* px;
+    float* py;
+    float* pz;
+    float* vx;
+    float* vy;
+    float* vz;
+    const unsigned char* fixedMasses;
+    const ClothMaterial* materials;
+    const unsigned* rowMaterials;
+    float massScale;
+    float restLengthScaleX;
+    float restLengthScaleY;
+    int width;
+    int height;
+    float dt;
+    float gravity;
+    //same test as PointMass::CheckCollisionWithBox, min > max for no box
+    float boxMinX, boxMaxX, boxMinZ, boxMaxZ, boxTop;
+};
+
+//rows [firstRow, lastRow) in place, in row-major order, kernel picked by width
+void StepGridRows(const GridStepContext& c, int firstRow, int lastRow);
+
+class GridCloth
+{
+public:
+    GridCloth(Shader* dotShader_, Shader* lineShader_);
+    ~GridCloth();
+
+    //masses on rows of leftBack + (x * xStep, 0, y * zStep), arrays reused when size is same
+    void Initialize(int width_, int height_, glm::vec3 leftBack, float xStep, float zStep);
+    void Update(float dt, SimpleBox* box);
+    //after Update : pulls springs back within (1 + maxStretch) of their length at Initialize
+    void LimitStrain(float dt, float maxStretch, int iterations, JobSystem* jobSystem);
+    void Draw(glm::mat4 projViewMat);
+
+    //true when the position changed
+    bool SetPosition(int index, glm::vec3 position);
+    /*
+     * Grid coarser than the one materials were tuned for (xScale, zScale times the spacing) :
+     * a mass stands for xScale * zScale of them and springs are longer by the scale of
+     * their direction. Spring damping works on each mass's own velocity (drag), so it
+     * scales with the mass. Spring constants stay, a lattice is about as stiff at any spacing.
+     */
+    void SetResolutionScale(float xScale, float zScale);
+    glm::vec3 GetPosition(int index) const;
+    //wakes the band of the mass when it changes, like SetPosition
+    void SetFixed(int index, bool fixed);
+    void SetAllFixed(bool fixed);
+
+    //for rollback of a diverging step : masses of the given tiles and every tile's sleep state
+    void SaveState(const std::vector<unsigned>& tiles, ClothSnapshot& snapshot) const;
+    void RestoreState(const std::vector<unsigned>& tiles, const ClothSnapshot& snapshot, bool keepVelocities);
+    //one entry per drawn spring, same order every call
+    void GetSpringLengths(std::vector<float>& lengths, std::vector<float>& restLengths) const;
+    //indices (into GetSpringLengths) of springs with an end in one of the tiles, may repeat
+    void GetTileSprings(const std::vector<unsigned>& tiles, std::vector<unsigned>& springIndices) const;
+    //rewrites lengths[i] of only those springs, lengths keeps its size
+    void GetSpringLengths(const std::vector<unsigned>& springIndices, std::vector<float>& lengths) const;
+    //largest sum of spring (0.5 * k) and damping constants on one mass, divided by its mass
+    void GetStiffnessRatios(float& stiffnessToMass, float& dampingToMass) const;
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    //shared by index, rowMaterials[y] is the material of row y
+    std::vector<ClothMaterial> materials;
+    std::vector<unsigned> rowMaterials;
+
+    //state, one entry per mass (index = y * width + x)
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<unsigned char> fixedMasses;
+
+    SleepTiles sleepTiles;
+    static const int rowsPerTile = 4;
+
+    StrainLimiter strainLimiter;
+
+private:
+    void UploadTopology();
+    //masses [first, last) of the band
+    void GetTileMasses(unsigned tile, size_t& first, size_t& last) const;
+
+    int width = 0, height = 0;
+
+    //positions at the end of the last step / SetPosition, also what the GPU buffer gets
+    std::vector<glm::vec3> drawPositions;
+    bool positionsDirty = true;
+    float massScale = 1.f;
+    float restLengthScaleX = 1.f;
+    float restLengthScaleZ = 1.f;
+    std::vector<float> inverseMasses;
+
+    Shader* dotShader;
+    Shader* lineShader;
+
+    unsigned vao = 0;
+    Buffer* positionBuffer = nullptr;
+    Buffer* lineIndexBuffer = nullptr;
+    unsigned lineIndexCount = 0;
+};
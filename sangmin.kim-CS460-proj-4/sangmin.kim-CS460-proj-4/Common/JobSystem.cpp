@@ -0,0 +1,150 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Small worker thread pool.
+ */
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threadCount)
+{
+	if (threadCount == 0)
+	{
+		const unsigned hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	workers.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+		workers.emplace_back(&JobSystem::WorkerLoop, this);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wakeCondition.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+/*
+ * Batches are claimed through an atomic counter, so helpers which start late
+ * (because workers were busy) just find nothing left and return.
+ * State is shared_ptr so it outlives this call for such late helpers.
+ */
+void JobSystem::ParallelFor(unsigned count, const std::function<void(unsigned)>& job, unsigned batchSize)
+{
+	if (count == 0)
+		return;
+
+	batchSize = std::max(batchSize, 1u);
+
+	const unsigned batchCount = (count + batchSize - 1) / batchSize;
+
+	if (workers.empty() || batchCount == 1)
+	{
+		for (unsigned i = 0; i < count; ++i)
+			job(i);
+		return;
+	}
+
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+	state->job = job;
+	state->count = count;
+	state->batchSize = batchSize;
+	state->nextIndex = 0;
+	state->doneCount = 0;
+
+	const unsigned helperCount = std::min(static_cast<unsigned>(workers.size()), batchCount - 1);
+
+	for (unsigned i = 0; i < helperCount; ++i)
+	{
+		Push([this, state]()
+			{
+				RunBatches(*state);
+				if (state->doneCount.load() == state->count)
+				{
+					std::lock_guard<std::mutex> lock(doneMutex);
+					doneCondition.notify_all();
+				}
+			});
+	}
+
+	RunBatches(*state);
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	doneCondition.wait(lock, [&state]() { return state->doneCount.load() == state->count; });
+}
+
+/*
+ * Without workers task runs right away on calling thread.
+ */
+void JobSystem::Submit(std::function<void()> task)
+{
+	if (workers.empty())
+	{
+		task();
+		return;
+	}
+
+	Push(std::move(task));
+}
+
+unsigned JobSystem::GetThreadCount() const
+{
+	return static_cast<unsigned>(workers.size());
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [this]() { return quit || !tasks.empty(); });
+
+			if (quit && tasks.empty())
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+void JobSystem::Push(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	wakeCondition.notify_one();
+}
+
+void JobSystem::RunBatches(ParallelForState& state)
+{
+	while (true)
+	{
+		const unsigned begin = state.nextIndex.fetch_add(state.batchSize);
+
+		if (begin >= state.count)
+			return;
+
+		const unsigned end = std::min(begin + state.batchSize, state.count);
+
+		for (unsigned i = begin; i < end; ++i)
+			state.job(i);
+
+		state.doneCount.fetch_add(end - begin);
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Small worker thread pool.
+ *                ParallelFor splits [0, count) into batches, calling thread works on batches too.
+ *                Submit queues one fire-and-forget task (e.g. asset loading).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+	//threadCount 0 : hardware_concurrency - 1 workers
+	JobSystem(unsigned threadCount = 0);
+	~JobSystem();
+
+	void ParallelFor(unsigned count, const std::function<void(unsigned)>& job, unsigned batchSize = 1);
+	void Submit(std::function<void()> task);
+	unsigned GetThreadCount() const;
+
+private:
+	struct ParallelForState
+	{
+		std::function<void(unsigned)> job;
+		unsigned count;
+		unsigned batchSize;
+		std::atomic<unsigned> nextIndex;
+		std::atomic<unsigned> doneCount;
+	};
+
+	void WorkerLoop();
+	void Push(std::function<void()> task);
+	static void RunBatches(ParallelForState& state);
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::mutex doneMutex;
+	std::condition_variable doneCondition;
+	bool quit = false;
+};
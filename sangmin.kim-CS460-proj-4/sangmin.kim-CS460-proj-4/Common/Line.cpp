@@ -6,12 +6,20 @@
 
 #include "Line.h"
 
-#include "ArcLengthTable.h"
-#include "CubicSpline.h"
+#include <algorithm>
+#include "glm/common.hpp"
+#include "CatmullRomPath.h"
+
+namespace
+{
+	const unsigned samplesPerSegment = 20;
+	const size_t inverseTableSize = 2048;
+}
 
 Line::Line()
 {
-	points.emplace_back(0.f, 0.f, -20.f);
+	std::vector<glm::vec3> points;
+
 	points.emplace_back(-25.f, 0.f, -10.f);
 	points.emplace_back(-32.f, 0.f, 2.5f);
 	points.emplace_back(-25.f, 0.f, 10.f);
@@ -19,73 +27,173 @@ Line::Line()
 	points.emplace_back(20.f, 0.f, 5.f);
 	points.emplace_back(50.f, 0.f, 0.f);
 	points.emplace_back(25.f, 0.f, -10.f);
+	points.emplace_back(0.f, 0.f, -20.f);
 
-	splines.push_back(new CubicSpline(points[0], points[1], points[2], points[3]));
-	splines.push_back(new CubicSpline(points[1], points[2], points[3], points[4]));
-	splines.push_back(new CubicSpline(points[2], points[3], points[4], points[5]));
-	splines.push_back(new CubicSpline(points[3], points[4], points[5], points[6]));
-	splines.push_back(new CubicSpline(points[4], points[5], points[6], points[7]));
-	splines.push_back(new CubicSpline(points[5], points[6], points[7], points[0]));
-	splines.push_back(new CubicSpline(points[6], points[7], points[0], points[1]));
-	splines.push_back(new CubicSpline(points[7], points[0], points[1], points[2]));
+	path = new CatmullRomPath(points, true);
 
-	const size_t splinesSize = splines.size();
+	const unsigned splinesSize = path->GetSegmentCount();
 
-	for(size_t i = 0; i < splinesSize; ++i)
+	coords.resize(splinesSize * samplesPerSegment);
+	for(unsigned i = 0; i < splinesSize; ++i)
 	{
-		CubicSpline* spline = splines[i];
+		SampleSegment(i);
+	}
 
-		for (float t = 0.f; t < 1.f; t += 0.05f)
-		{
-			glm::vec3 newCoord = spline->Interpolate(t);
+	BuildInverseTable();
 
-			coords.push_back(newCoord);
-		}
+	checkSplineOffset = splinesSize > 0 ? 1.f / static_cast<float>(splinesSize) : 0.f;
+}
+
+void Line::SampleSegment(unsigned segment)
+{
+	const CubicSpline& spline = path->GetSegment(segment);
+	glm::vec3* out = coords.data() + segment * samplesPerSegment;
+
+	for(unsigned i = 0; i < samplesPerSegment; ++i)
+	{
+		out[i] = spline.Interpolate(static_cast<float>(i) / static_cast<float>(samplesPerSegment));
 	}
+}
 
-	table = new ArcLengthTable();
+/*
+ * Locate reads the path's per segment tables, so no quadrature runs here
+ * and the cost does not grow with the point count past log n per entry.
+ */
+void Line::BuildInverseTable()
+{
+	const unsigned splinesSize = path->GetSegmentCount();
 
-	//table->SetTable(splines[0]);
+	inverseTable.resize(inverseTableSize);
+	inverseScale = static_cast<double>(inverseTableSize - 1);
 
-	for(size_t i = 0; i < splinesSize; ++i)
+	if (splinesSize == 0)
 	{
-		table->SetTable(splines[i]);
+		for(size_t k = 0; k < inverseTableSize; ++k)
+			inverseTable[k] = static_cast<double>(k) / inverseScale;
+		return;
 	}
 
-	table->FinializeTable();
+	const double splineCount = static_cast<double>(splinesSize);
+	const float totalLength = path->GetTotalLength();
+
+	for(size_t k = 0; k + 1 < inverseTableSize; ++k)
+	{
+		unsigned segment;
+		float t;
+		path->Locate(static_cast<float>(static_cast<double>(k) / inverseScale) * totalLength, segment, t);
 
-	checkSplineOffset = 1.f / static_cast<float>(splines.size());
+		inverseTable[k] = (static_cast<double>(segment) + static_cast<double>(t)) / splineCount;
+	}
+
+	//closed path wraps total length back to 0
+	inverseTable.back() = 1.0;
 }
 
-Line::~Line()
+/*
+ * Mirror what the path did to its segments, then sample only the rebuilt ones.
+ */
+void Line::ApplyEdit()
 {
-	const size_t splinesSize = splines.size();
-	for(size_t i = 0; i < splinesSize; ++i)
+	const CatmullRomPath::EditRange& edit = path->GetLastEdit();
+	const unsigned splinesSize = path->GetSegmentCount();
+
+	if (splinesSize == 0)
+	{
+		coords.clear();
+	}
+	else if (edit.segmentChange > 0)
 	{
-		delete splines[i];
+		coords.insert(coords.begin() + edit.slot * samplesPerSegment,
+			static_cast<size_t>(edit.segmentChange) * samplesPerSegment, glm::vec3(0.f));
+	}
+	else if (edit.segmentChange < 0)
+	{
+		const size_t first = static_cast<size_t>(edit.slot) * samplesPerSegment;
+		const size_t last = std::min(coords.size(), first + static_cast<size_t>(-edit.segmentChange) * samplesPerSegment);
+
+		coords.erase(coords.begin() + first, coords.begin() + last);
 	}
+
+	const int count = static_cast<int>(splinesSize);
+	for(int i = edit.firstSegment; i <= edit.lastSegment; ++i)
+	{
+		SampleSegment(static_cast<unsigned>(((i % count) + count) % count));
+	}
+
+	BuildInverseTable();
+
+	checkSplineOffset = splinesSize > 0 ? 1.f / static_cast<float>(splinesSize) : 0.f;
+
+	if (interpolatingSplineIndex >= splinesSize)
+		interpolatingSplineIndex = 0;
+}
+
+void Line::InsertPoint(unsigned index, const glm::vec3& point)
+{
+	path->Insert(index, point);
+	ApplyEdit();
+}
+
+void Line::RemovePoint(unsigned index)
+{
+	path->Remove(index);
+	ApplyEdit();
+}
+
+void Line::MovePoint(unsigned index, const glm::vec3& point)
+{
+	path->Move(index, point);
+	ApplyEdit();
+}
+
+Line::~Line()
+{
+	delete path;
 }
 
 float Line::GetParam(float dist)
 {
-	return static_cast<float>(table->GetParamValue(dist));
+	float param;
+	GetParams(&dist, &param, 1);
+	return param;
+}
+
+void Line::GetParams(const float* dists, float* params, size_t count) const
+{
+	const float scale = static_cast<float>(inverseScale);
+	const size_t lastIndex = inverseTable.size() - 2;
+	const double* values = inverseTable.data();
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		const float position = glm::clamp(dists[i], 0.f, 1.f) * scale;
+		size_t index = static_cast<size_t>(position);
+		if (index > lastIndex)
+			index = lastIndex;
+
+		const float k = position - static_cast<float>(index);
+		const float u0 = static_cast<float>(values[index]);
+		const float u1 = static_cast<float>(values[index + 1]);
+
+		params[i] = u0 + k * (u1 - u0);
+	}
 }
 
 glm::vec3 Line::CheckInterpolation(float param)
 {
-	return splines[interpolatingSplineIndex]->Interpolate(param);
+	return path->GetSegment(interpolatingSplineIndex).Interpolate(param);
 }
 
 glm::vec3 Line::CheckDerivativeInterpolation(float param)
 {
-	return splines[interpolatingSplineIndex]->InterpolateDerivative(param);
+	return path->GetSegment(interpolatingSplineIndex).InterpolateDerivative(param);
 }
 
 void Line::ChangeSplineIndex()
 {
 	interpolatingSplineIndex++;
 
-	if (interpolatingSplineIndex >= splines.size())
+	if (interpolatingSplineIndex >= path->GetSegmentCount())
 	{
 		interpolatingSplineIndex = 0;
 	}
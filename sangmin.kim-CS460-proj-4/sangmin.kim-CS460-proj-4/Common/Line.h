@@ -8,8 +8,7 @@
 #include <vector>
 #include "glm/vec3.hpp"
 
-class ArcLengthTable;
-class CubicSpline;
+class CatmullRomPath;
 
 class Line
 {
@@ -21,17 +20,33 @@ public:
 		return coords;
 	}
 	float GetParam(float dist);
+	//dists, params normalized to [0, 1]
+	void GetParams(const float* dists, float* params, size_t count) const;
 	glm::vec3 CheckInterpolation(float param);
 	glm::vec3 CheckDerivativeInterpolation(float param);
 	void ChangeSplineIndex();
-	ArcLengthTable* table;
+
+	//path edits go through here, only segments the path rebuilt are sampled again
+	void InsertPoint(unsigned index, const glm::vec3& point);
+	void RemovePoint(unsigned index);
+	void MovePoint(unsigned index, const glm::vec3& point);
+
+	const CatmullRomPath& GetPath() const { return *path; }
 
 private:
+	void ApplyEdit();
+	void SampleSegment(unsigned segment);
+	void BuildInverseTable();
+
+	CatmullRomPath* path;
+
 	float checkSplineOffset;
-	std::vector<glm::vec3> points;
+	//samplesPerSegment coords for each segment, in segment order
 	std::vector<glm::vec3> coords;
 
-	std::vector<CubicSpline*> splines;
+	//inverseTable[k] = u(k / (size - 1)), read from path's per segment tables
+	std::vector<double> inverseTable;
+	double inverseScale = 0.0;
 
 	unsigned interpolatingSplineIndex = 0;
 
@@ -0,0 +1,130 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Read only memory mapped file.
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return;
+	}
+	mappingHandle = mapping;
+
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		Close();
+		return;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return;
+
+	struct stat fileStat;
+	if (fstat(descriptor, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		Close();
+		return;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (view == MAP_FAILED)
+	{
+		Close();
+		return;
+	}
+
+	data = static_cast<const char*>(view);
+	size = static_cast<size_t>(fileStat.st_size);
+	madvise(view, size, MADV_SEQUENTIAL);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
+
+const char* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
+
+unsigned long long MappedFile::Hash() const
+{
+	const unsigned long long prime = 1099511628211ull;
+	unsigned long long hash = 14695981039346656037ull;
+
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= prime;
+	}
+	return hash;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle)
+		CloseHandle(fileHandle);
+
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (data)
+		munmap(const_cast<char*>(data), size);
+	if (descriptor >= 0)
+		close(descriptor);
+
+	descriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
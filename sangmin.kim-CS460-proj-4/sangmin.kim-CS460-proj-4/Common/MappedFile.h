@@ -0,0 +1,39 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Read only memory mapped file (Win32 file mapping / POSIX mmap).
+ *                Whole file is mapped, so files larger than 4GB work on 64 bit builds.
+ */
+
+#pragma once
+
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool IsOpen() const;
+	const char* GetData() const;
+	size_t GetSize() const;
+	//FNV-1a over whole content, used to detect stale caches.
+	unsigned long long Hash() const;
+
+private:
+	void Close();
+
+	const char* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int descriptor = -1;
+#endif
+};
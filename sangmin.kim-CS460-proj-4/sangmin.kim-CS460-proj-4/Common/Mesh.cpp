@@ -4,13 +4,12 @@
 
 //#include <gl/GL.h>
 #include <GL/glew.h>
+#include <cmath>
+#include <functional>
 #include <iostream>
-#include <set>
+#include "JobSystem.h"
 #include "Mesh.h"
 
-
-#include <glm/gtc/epsilon.hpp>
-
 // Initialize the data members in the mesh
 void Mesh::initData()
 {
@@ -116,19 +115,11 @@ glm::vec3 Mesh::getCentroidVector(glm::vec3 vVertex)
 /////////////////////////////////////////////////////
 /////////////////////////////////////////////////////
 
-struct compareVec
-{
-    bool operator() (const glm::vec3& lhs, const glm::vec3& rhs) const
-    {
-        float V = glm::dot( lhs, rhs );
-        bool bRetCode = glm::epsilonNotEqual( V, 1.0f, FLT_EPSILON);
-
-        return bRetCode;
-    }
-};
-
 /////////////////////////////////////////////////////////
-int Mesh::calcVertexNormals(GLboolean bFlipNormals)
+// 1. per face corner weighted normal (flat array, 3 per face)
+// 2. vertex -> corner lists by counting sort, corners stay in face order
+// 3. per vertex gather in that order : no atomics, same sum for any thread count
+int Mesh::calcVertexNormals(GLboolean bFlipNormals, NormalWeighting weighting, JobSystem *jobSystem)
 {
     int rFlag = -1;
 
@@ -139,75 +130,104 @@ int Mesh::calcVertexNormals(GLboolean bFlipNormals)
         return rFlag;
     }
 
-    // Pre-built vertex normals
-//    if( !vertexNormals.empty() )
-//    {
-//        std::cout << "Vertex normals specified by the file. Skipping this step." << std::endl;
-//        return rFlag;
-//    }
-
     // Initialize vertex normals
-    GLuint  numVertices = getVertexCount();
-    vertexNormals.resize( numVertices, glm::vec3(0.0f) );
-    vertexNormalDisplay.resize( numVertices * 2, glm::vec3(0.0f) );
+    const GLuint  numVertices = getVertexCount();
+    const size_t  numCorners = (vertexIndices.size() / 3) * 3;
+    const GLuint  numFaces = static_cast<GLuint>( numCorners / 3 );
 
-    std::vector< std::set< glm::vec3, compareVec > >  vNormalSet;
-    vNormalSet.resize( numVertices );
+    vertexNormals.assign( numVertices, glm::vec3(0.0f) );
+    vertexNormalDisplay.resize( numVertices * 2, glm::vec3(0.0f) );
 
-    // For every face
-    glm::uint index = 0;
-    for (; index < vertexIndices.size(); )
+    auto parallelFor = [jobSystem]( GLuint count, const std::function<void(unsigned)> &job )
     {
-        GLuint a = vertexIndices.at(index++);
-        GLuint b = vertexIndices.at(index++);
-        GLuint c = vertexIndices.at(index++);
+        if( jobSystem )
+            jobSystem->ParallelFor( count, job, 4096 );
+        else
+        {
+            for( GLuint i = 0; i < count; ++i )
+                job( i );
+        }
+    };
 
-        glm::vec3  vA = vertexBuffer[a];
-        glm::vec3  vB = vertexBuffer[b];
-        glm::vec3  vC = vertexBuffer[c];
+    std::vector<glm::vec3>  cornerNormals( numCorners );
 
-        // Edge vectors
-        glm::vec3  E1 = vB - vA;
-        glm::vec3  E2 = vC - vA;
+    parallelFor( numFaces, [this, &cornerNormals, bFlipNormals, weighting]( unsigned face )
+    {
+        const GLuint *corners = vertexIndices.data() + face * 3;
 
-        glm::vec3  N = glm::normalize( glm::cross( E1, E2 ) );
+        const glm::vec3  vA = vertexBuffer[corners[0]];
+        const glm::vec3  vB = vertexBuffer[corners[1]];
+        const glm::vec3  vC = vertexBuffer[corners[2]];
 
+        // |E1 x E2| is twice the area, so the raw cross product is already area weighted
+        glm::vec3  N = glm::cross( vB - vA, vC - vA );
         if( bFlipNormals )
             N = N * -1.0f;
 
-        // For vertex a
-        vNormalSet.at( a ).insert( N );
-        vNormalSet.at( b ).insert( N );
-        vNormalSet.at( c ).insert( N );
-    }
-
-    // Now sum up the values per vertex
-    for( int index =0; index < vNormalSet.size(); ++index )
-    {
-        glm::vec3  vNormal(0.0f);
+        glm::vec3 *out = cornerNormals.data() + face * 3;
 
-//        if( vNormalSet[index].size() <= 0 )
-//            std::cout << "[Normal Set](" << index << ") Size = " << vNormalSet[index].size() << std::endl;
+        if( weighting == AREA_WEIGHTED )
+        {
+            out[0] = out[1] = out[2] = N;
+            return;
+        }
 
-        setNormalLength(0.05f);
+        const float length = glm::length( N );
+        if( length <= 0.0f )
+        {
+            out[0] = out[1] = out[2] = glm::vec3( 0.0f );
+            return;
+        }
+        N /= length;
 
-        auto nIt = vNormalSet[index].begin();
-        while(nIt != vNormalSet[index].end())
+        const glm::vec3 points[3] = { vA, vB, vC };
+        for( int corner = 0; corner < 3; ++corner )
         {
-            vNormal += (*nIt);
-            ++nIt;
+            const glm::vec3 e1 = points[(corner + 1) % 3] - points[corner];
+            const glm::vec3 e2 = points[(corner + 2) % 3] - points[corner];
+            const float denominator = glm::length( e1 ) * glm::length( e2 );
+
+            const float angle = denominator > 0.0f
+                ? std::acos( glm::clamp( glm::dot( e1, e2 ) / denominator, -1.0f, 1.0f ) )
+                : 0.0f;
+
+            out[corner] = N * angle;
         }
+    } );
+
+    // vertex -> corners (CSR)
+    std::vector<GLuint>  cornerOffsets( numVertices + 1, 0 );
+    for( size_t i = 0; i < numCorners; ++i )
+        ++cornerOffsets[vertexIndices[i] + 1];
+    for( GLuint v = 0; v < numVertices; ++v )
+        cornerOffsets[v + 1] += cornerOffsets[v];
+
+    std::vector<GLuint>  vertexCorners( numCorners );
+    {
+        std::vector<GLuint>  fill( cornerOffsets.begin(), cornerOffsets.end() - 1 );
+        for( size_t i = 0; i < numCorners; ++i )
+            vertexCorners[fill[vertexIndices[i]]++] = static_cast<GLuint>( i );
+    }
+
+    setNormalLength(0.05f);
+
+    parallelFor( numVertices, [this, &cornerNormals, &cornerOffsets, &vertexCorners]( unsigned index )
+    {
+        glm::vec3  vNormal(0.0f);
+
+        for( GLuint i = cornerOffsets[index]; i < cornerOffsets[index + 1]; ++i )
+            vNormal += cornerNormals[vertexCorners[i]];
 
         // save vertex normal
-        vertexNormals[index] = glm::normalize( vNormal );
+        const float length = glm::length( vNormal );
+        vertexNormals[index] = length > 0.0f ? vNormal / length : glm::vec3( 0.0f );
 
         // save normal to display
         glm::vec3  vA = vertexBuffer[index];
 
         vertexNormalDisplay[2*index] = vA;
         vertexNormalDisplay[(2*index) + 1] = vA + ( normalLength * vertexNormals[index] );
-
-    }
+    } );
 
     // success
     rFlag = 0;
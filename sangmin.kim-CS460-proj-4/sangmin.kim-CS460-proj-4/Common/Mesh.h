@@ -9,6 +9,7 @@
 
 #include <glm/glm.hpp>
 
+class JobSystem;
 
 class Mesh
 {
@@ -43,7 +44,14 @@ public:
     void initData();
 
     // calculate vertex normals
-    int calcVertexNormals(GLboolean bFlipNormals = false);
+    // Face normals weighted by area or by corner angle are summed per vertex.
+    // Result does not depend on thread count (fixed summation order).
+    enum NormalWeighting { AREA_WEIGHTED = 0,
+                           ANGLE_WEIGHTED };
+
+    int calcVertexNormals(GLboolean bFlipNormals = false,
+                          NormalWeighting weighting = ANGLE_WEIGHTED,
+                          JobSystem *jobSystem = nullptr);
 
     // calculate the "display" normals
     void calcVertexNormalsForDisplay(GLboolean bFlipNormals = false);
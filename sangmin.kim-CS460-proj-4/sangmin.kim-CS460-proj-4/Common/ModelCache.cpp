@@ -0,0 +1,477 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Versioned binary cache of imported animating object.
+ *
+ *                Layout : Header, then sections each aligned to 16 bytes
+ *                positions, normals, texCoords, boneIds, boneWeights, indices, meshes,
+ *                materials, bones, skeleton, clips.
+ */
+
+#include "ModelCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "AnimationModel.h"
+#include "AnimationModelDatas.h"
+#include "AnimationSkeleton.h"
+#include "BoneStorageManager.h"
+#include "CompressedClip.h"
+#include "MappedFile.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#define MODEL_CACHE_VERSION 2
+
+namespace
+{
+	const char cacheMagic[4] = { 'A', 'M', 'C', 'H' };
+	const size_t sectionAlignment = 16;
+
+	struct CacheHeader
+	{
+		char magic[4];
+		glm::uint version;
+		glm::uint64 sourceHash;
+		glm::uint maxBoneInfluences;
+		glm::uint vertexCount;
+		glm::uint indexCount;
+		glm::uint meshCount;
+		glm::uint materialCount;
+		glm::uint boneCount;
+		glm::uint nodeCount;
+		glm::uint clipCount;
+		glm::uint isTextured;
+		glm::uint vertexCacheOptimized;
+	};
+
+	class CacheWriter
+	{
+	public:
+		CacheWriter(const std::string& path) : stream(path, std::ios::binary | std::ios::trunc)
+		{
+		}
+
+		bool IsOpen() const
+		{
+			return stream.is_open();
+		}
+
+		bool IsGood() const
+		{
+			return stream.good();
+		}
+
+		void WriteBytes(const void* bytes, size_t count)
+		{
+			stream.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(count));
+			offset += count;
+		}
+
+		template <typename T>
+		void Write(const T& value)
+		{
+			WriteBytes(&value, sizeof(T));
+		}
+
+		template <typename T>
+		void WriteArray(const T* values, size_t count)
+		{
+			Align();
+			WriteBytes(values, sizeof(T) * count);
+		}
+
+		template <typename T>
+		void WriteVector(const std::vector<T>& values)
+		{
+			Write(static_cast<glm::uint64>(values.size()));
+			WriteArray(values.data(), values.size());
+		}
+
+		void WriteString(const std::string& value)
+		{
+			Write(static_cast<glm::uint>(value.size()));
+			WriteBytes(value.data(), value.size());
+		}
+
+		void Align()
+		{
+			static const char zeros[sectionAlignment] = { 0 };
+			const size_t remainder = offset % sectionAlignment;
+			if (remainder != 0)
+				WriteBytes(zeros, sectionAlignment - remainder);
+		}
+
+	private:
+		std::ofstream stream;
+		size_t offset = 0;
+	};
+
+	/*
+	 * Bounds checked reader over mapped bytes. Arrays are returned as pointers into mapping.
+	 */
+	class CacheReader
+	{
+	public:
+		CacheReader(const char* data, size_t size) : begin(data), cursor(data), end(data + size)
+		{
+		}
+
+		bool IsValid() const
+		{
+			return valid;
+		}
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			if (!Require(sizeof(T)))
+				return false;
+
+			std::memcpy(static_cast<void*>(&value), cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		template <typename T>
+		const T* View(size_t count)
+		{
+			Align();
+			if (!Require(sizeof(T) * count))
+				return nullptr;
+
+			const T* values = reinterpret_cast<const T*>(cursor);
+			cursor += sizeof(T) * count;
+			return values;
+		}
+
+		template <typename T>
+		bool ReadVector(std::vector<T>& values)
+		{
+			glm::uint64 count = 0;
+			if (!Read(count))
+				return false;
+
+			const T* source = View<T>(static_cast<size_t>(count));
+			if (!source)
+				return false;
+
+			values.assign(source, source + count);
+			return true;
+		}
+
+		bool ReadString(std::string& value)
+		{
+			glm::uint length = 0;
+			if (!Read(length) || !Require(length))
+				return false;
+
+			value.assign(cursor, length);
+			cursor += length;
+			return true;
+		}
+
+	private:
+		bool Require(size_t count)
+		{
+			if (!valid || static_cast<size_t>(end - cursor) < count)
+				valid = false;
+			return valid;
+		}
+
+		void Align()
+		{
+			const size_t remainder = static_cast<size_t>(cursor - begin) % sectionAlignment;
+			if (remainder != 0)
+			{
+				if (Require(sectionAlignment - remainder))
+					cursor += sectionAlignment - remainder;
+			}
+		}
+
+		const char* begin;
+		const char* cursor;
+		const char* end;
+		bool valid = true;
+	};
+
+	void WriteCompressedClipArrays(CacheWriter& writer, const std::vector<glm::u16>& times,
+		const std::vector<QuantizedKey>& keys)
+	{
+		writer.WriteVector(times);
+		writer.WriteVector(keys);
+	}
+}
+
+std::string ModelCache::GetCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".cache";
+}
+
+/*
+ * FNV-1a over source bytes, mixed with settings that change imported result.
+ */
+glm::uint64 ModelCache::HashSource(const std::string& sourcePath, int maxBoneInfluences)
+{
+	MappedFile source(sourcePath);
+	if (!source.IsOpen())
+		return 0;
+
+	glm::uint64 hash = source.Hash();
+	hash ^= static_cast<glm::uint64>(maxBoneInfluences);
+	hash *= 1099511628211ull;
+
+	return hash;
+}
+
+bool ModelCache::Load(const std::string& sourcePath, AnimationModel* model)
+{
+	MappedFile* file = new MappedFile(GetCachePath(sourcePath));
+	if (!file->IsOpen())
+	{
+		delete file;
+		return false;
+	}
+
+	CacheReader reader(file->GetData(), file->GetSize());
+
+	CacheHeader header;
+	if (!reader.Read(header) || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0
+		|| header.version != MODEL_CACHE_VERSION)
+	{
+		std::cout << "Model cache version mismatch : " << GetCachePath(sourcePath) << std::endl;
+		delete file;
+		return false;
+	}
+
+	AnimationModelDatas* datas = model->datas;
+
+	if (header.maxBoneInfluences != static_cast<glm::uint>(datas->maxBoneInfluences)
+		|| header.vertexCacheOptimized != (datas->optimizeVertexCache ? 1u : 0u)
+		|| header.sourceHash != HashSource(sourcePath, datas->maxBoneInfluences))
+	{
+		std::cout << "Model cache is stale : " << GetCachePath(sourcePath) << std::endl;
+		delete file;
+		return false;
+	}
+
+	const int groupCount = (static_cast<int>(header.maxBoneInfluences) + 3) / 4;
+	const size_t groupTotal = static_cast<size_t>(header.vertexCount) * groupCount;
+
+	const glm::vec3* positionData = reader.View<glm::vec3>(header.vertexCount);
+	const glm::vec3* normalData = reader.View<glm::vec3>(header.vertexCount);
+	const glm::vec2* texCoordData = reader.View<glm::vec2>(header.vertexCount);
+	const glm::u16vec4* boneIdData = reader.View<glm::u16vec4>(groupTotal);
+	const glm::u16vec4* boneWeightData = reader.View<glm::u16vec4>(groupTotal);
+	const unsigned* indexData = reader.View<unsigned>(header.indexCount);
+	const BasicMeshEntry* meshData = reader.View<BasicMeshEntry>(header.meshCount);
+
+	//Materials
+	struct CachedMaterial
+	{
+		glm::vec3 ambient, diffuse, specular;
+		std::string diffusePath, specularPath;
+	};
+	std::vector<CachedMaterial> cachedMaterials(header.materialCount);
+	for (CachedMaterial& material : cachedMaterials)
+	{
+		reader.Read(material.ambient);
+		reader.Read(material.diffuse);
+		reader.Read(material.specular);
+		reader.ReadString(material.diffusePath);
+		reader.ReadString(material.specularPath);
+	}
+
+	//Bones
+	const glm::mat4* offsetData = reader.View<glm::mat4>(header.boneCount);
+	std::vector<std::string> boneNames(header.boneCount);
+	for (std::string& name : boneNames)
+		reader.ReadString(name);
+
+	//Skeleton
+	AnimationSkeleton* skeleton = new AnimationSkeleton();
+	reader.ReadVector(skeleton->parents);
+	reader.ReadVector(skeleton->boneIndices);
+	reader.ReadVector(skeleton->bindPose.rotations);
+	reader.ReadVector(skeleton->bindPose.translations);
+	reader.ReadVector(skeleton->bindPose.scales);
+
+	skeleton->clips.resize(header.clipCount);
+	for (AnimationSkeleton::ClipInfo& clip : skeleton->clips)
+	{
+		clip.animation = nullptr;
+		clip.compressed = new CompressedClip();
+		CompressedClip* compressed = clip.compressed;
+
+		reader.Read(clip.durationTicks);
+		reader.Read(clip.ticksPerSecond);
+		reader.Read(compressed->durationTicks);
+		glm::uint64 rawMemory = 0;
+		reader.Read(rawMemory);
+		compressed->rawMemory = static_cast<size_t>(rawMemory);
+
+		reader.ReadVector(compressed->trackIndices);
+		reader.ReadVector(compressed->tracks);
+		reader.ReadVector(compressed->rotationTimes);
+		reader.ReadVector(compressed->rotationKeys);
+		reader.ReadVector(compressed->translationTimes);
+		reader.ReadVector(compressed->translationKeys);
+		reader.ReadVector(compressed->scaleTimes);
+		reader.ReadVector(compressed->scaleKeys);
+	}
+
+	if (!reader.IsValid() || skeleton->parents.size() != header.nodeCount)
+	{
+		std::cout << "Model cache is corrupted : " << GetCachePath(sourcePath) << std::endl;
+		delete skeleton;
+		delete file;
+		return false;
+	}
+
+	datas->numVertices = static_cast<int>(header.vertexCount);
+	datas->numIndices = static_cast<int>(header.indexCount);
+	datas->meshes.assign(meshData, meshData + header.meshCount);
+
+	datas->boneInfos.clear();
+	datas->boneInfos.reserve(header.boneCount);
+	for (glm::uint i = 0; i < header.boneCount; ++i)
+	{
+		datas->boneInfos.emplace_back(offsetData[i]);
+		datas->boneName2IndexMap[boneNames[i]] = i;
+	}
+
+	datas->materials.resize(header.materialCount);
+	for (glm::uint i = 0; i < header.materialCount; ++i)
+	{
+		Material& material = datas->materials[i];
+		const CachedMaterial& cached = cachedMaterials[i];
+
+		material.ambientColor = cached.ambient;
+		material.diffuseColor = cached.diffuse;
+		material.specularColor = cached.specular;
+
+		if (!cached.diffusePath.empty())
+		{
+			material.pDiffuse = TextureCache::Get().Acquire(cached.diffusePath);
+			if (!material.pDiffuse)
+				std::cout << "Failed to Load diffuse texture" << std::endl;
+		}
+		if (!cached.specularPath.empty())
+		{
+			material.pSpecular = TextureCache::Get().Acquire(cached.specularPath);
+			if (!material.pSpecular)
+				std::cout << "Failed to Load specular texture" << std::endl;
+		}
+	}
+
+	model->isTextured = header.isTextured ? AnimationModel::TextureInfos::TEXTURED : AnimationModel::TextureInfos::NONE;
+
+	datas->storage = new BoneStorageManager(datas->maxBoneInfluences);
+	datas->pendingStreams.positions = positionData;
+	datas->pendingStreams.texCoords = texCoordData;
+	datas->pendingStreams.normals = normalData;
+	datas->pendingStreams.boneIds = boneIdData;
+	datas->pendingStreams.boneWeights = boneWeightData;
+	datas->pendingStreams.indices = indexData;
+	datas->pendingMapping = file;
+
+	model->skeleton = skeleton;
+
+	std::cout << "Load model cache : " << GetCachePath(sourcePath) << std::endl;
+	return true;
+}
+
+bool ModelCache::Save(const std::string& sourcePath, const AnimationModel* model)
+{
+	const AnimationModelDatas* datas = model->datas;
+	const AnimationSkeleton* skeleton = model->skeleton;
+
+	if (!skeleton->IsCompressed())
+	{
+		std::cout << "Model cache needs compressed clips : " << sourcePath << std::endl;
+		return false;
+	}
+
+	CacheWriter writer(GetCachePath(sourcePath));
+	if (!writer.IsOpen())
+		return false;
+
+	CacheHeader header;
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = MODEL_CACHE_VERSION;
+	header.sourceHash = HashSource(sourcePath, datas->maxBoneInfluences);
+	header.maxBoneInfluences = static_cast<glm::uint>(datas->maxBoneInfluences);
+	header.vertexCount = static_cast<glm::uint>(datas->numVertices);
+	header.indexCount = static_cast<glm::uint>(datas->numIndices);
+	header.meshCount = static_cast<glm::uint>(datas->meshes.size());
+	header.materialCount = static_cast<glm::uint>(datas->materials.size());
+	header.boneCount = static_cast<glm::uint>(datas->boneInfos.size());
+	header.nodeCount = skeleton->GetNodeCount();
+	header.clipCount = skeleton->GetClipCount();
+	header.isTextured = model->isTextured == AnimationModel::TextureInfos::TEXTURED ? 1 : 0;
+	header.vertexCacheOptimized = datas->optimizeVertexCache ? 1 : 0;
+	writer.Write(header);
+
+	writer.WriteArray(datas->positions.data(), datas->positions.size());
+	writer.WriteArray(datas->normals.data(), datas->normals.size());
+	writer.WriteArray(datas->texCoords.data(), datas->texCoords.size());
+	writer.WriteArray(datas->storage->boneIds.data(), datas->storage->boneIds.size());
+	writer.WriteArray(datas->storage->weights.data(), datas->storage->weights.size());
+	writer.WriteArray(datas->indices.data(), datas->indices.size());
+	writer.WriteArray(datas->meshes.data(), datas->meshes.size());
+
+	for (const Material& material : datas->materials)
+	{
+		writer.Write(material.ambientColor);
+		writer.Write(material.diffuseColor);
+		writer.Write(material.specularColor);
+		writer.WriteString(material.pDiffuse ? material.pDiffuse->GetFilePath() : std::string());
+		writer.WriteString(material.pSpecular ? material.pSpecular->GetFilePath() : std::string());
+	}
+
+	std::vector<glm::mat4> offsets;
+	std::vector<std::string> boneNames(datas->boneInfos.size());
+	offsets.reserve(datas->boneInfos.size());
+	for (const BoneInfo& bone : datas->boneInfos)
+		offsets.push_back(bone.offsetMat);
+	for (const auto& pair : datas->boneName2IndexMap)
+		boneNames[pair.second] = pair.first;
+
+	writer.WriteArray(offsets.data(), offsets.size());
+	for (const std::string& name : boneNames)
+		writer.WriteString(name);
+
+	writer.WriteVector(skeleton->parents);
+	writer.WriteVector(skeleton->boneIndices);
+	writer.WriteVector(skeleton->bindPose.rotations);
+	writer.WriteVector(skeleton->bindPose.translations);
+	writer.WriteVector(skeleton->bindPose.scales);
+
+	for (const AnimationSkeleton::ClipInfo& clip : skeleton->clips)
+	{
+		const CompressedClip* compressed = clip.compressed;
+
+		writer.Write(clip.durationTicks);
+		writer.Write(clip.ticksPerSecond);
+		writer.Write(compressed->durationTicks);
+		writer.Write(static_cast<glm::uint64>(compressed->rawMemory));
+
+		writer.WriteVector(compressed->trackIndices);
+		writer.WriteVector(compressed->tracks);
+		WriteCompressedClipArrays(writer, compressed->rotationTimes, compressed->rotationKeys);
+		WriteCompressedClipArrays(writer, compressed->translationTimes, compressed->translationKeys);
+		WriteCompressedClipArrays(writer, compressed->scaleTimes, compressed->scaleKeys);
+	}
+
+	if (!writer.IsGood())
+	{
+		std::cout << "Failed to write model cache : " << GetCachePath(sourcePath) << std::endl;
+		return false;
+	}
+
+	std::cout << "Write model cache : " << GetCachePath(sourcePath) << std::endl;
+	return true;
+}
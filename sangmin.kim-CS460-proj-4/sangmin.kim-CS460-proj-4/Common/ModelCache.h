@@ -0,0 +1,30 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Versioned binary cache of imported animating object.
+ *                Holds final positions / normals / texCoords / indices, packed bone ids / weights,
+ *                mesh entries, materials, bones, skeleton and compressed clips.
+ *                Cache is memory mapped and vertex streams are uploaded straight from the mapping
+ *                (mapping is handed to AnimationModelDatas until UploadPending).
+ *                Stale when source file hash, load settings or format version differ.
+ */
+
+#pragma once
+
+#include <string>
+#include <glm/gtc/type_precision.hpp>
+
+class AnimationModel;
+
+class ModelCache
+{
+public:
+	static std::string GetCachePath(const std::string& sourcePath);
+	static glm::uint64 HashSource(const std::string& sourcePath, int maxBoneInfluences);
+
+	//false if cache is missing / stale / corrupted, model is left untouched then.
+	//No GL calls, textures are only decoded.
+	static bool Load(const std::string& sourcePath, AnimationModel* model);
+	//model must be imported, compressed, and its CPU side vertex data still alive.
+	static bool Save(const std::string& sourcePath, const AnimationModel* model);
+};
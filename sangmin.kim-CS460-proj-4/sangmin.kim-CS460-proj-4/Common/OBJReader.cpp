@@ -2,6 +2,7 @@
 // Created by pushpak on 4/5/18.
 //
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #define GLM_ENABLE_EXPERIMENTAL
@@ -9,8 +10,145 @@
 #include <cfloat>
 #include <chrono>
 #include <set>
+#include "JobSystem.h"
+#include "MappedFile.h"
 #include "OBJReader.h"
 
+namespace
+{
+    const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                   1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+    inline bool IsSpace( char c )
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool IsDigit( char c )
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline void SkipSpaces( const char *&p, const char *end )
+    {
+        while( p < end && IsSpace(*p) )
+            ++p;
+    }
+
+    // Decimal / exponent float scanner, p is left after the number
+    bool ScanFloat( const char *&p, const char *end, float &value )
+    {
+        SkipSpaces( p, end );
+
+        bool negative = false;
+        if( p < end && (*p == '-' || *p == '+') )
+        {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        const char *start = p;
+        unsigned long long mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+
+        for( ; p < end && IsDigit(*p); ++p )
+        {
+            if( digits < 18 )
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                ++digits;
+            }
+            else
+                ++exponent;
+        }
+
+        if( p < end && *p == '.' )
+        {
+            ++p;
+            for( ; p < end && IsDigit(*p); ++p )
+            {
+                if( digits < 18 )
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    ++digits;
+                    --exponent;
+                }
+            }
+        }
+
+        if( p == start )
+            return false;
+
+        if( p < end && (*p == 'e' || *p == 'E') )
+        {
+            ++p;
+            bool negativeExponent = false;
+            if( p < end && (*p == '-' || *p == '+') )
+            {
+                negativeExponent = (*p == '-');
+                ++p;
+            }
+
+            int e = 0;
+            for( ; p < end && IsDigit(*p); ++p )
+                e = e * 10 + (*p - '0');
+
+            exponent += negativeExponent ? -e : e;
+        }
+
+        double result = static_cast<double>(mantissa);
+        while( exponent > 18 )  { result *= 1e18; exponent -= 18; }
+        while( exponent < -18 ) { result /= 1e18; exponent += 18; }
+        result = exponent >= 0 ? result * powersOfTen[exponent] : result / powersOfTen[-exponent];
+
+        value = static_cast<float>( negative ? -result : result );
+        return true;
+    }
+
+    bool ScanInt( const char *&p, const char *end, long long &value )
+    {
+        bool negative = false;
+        if( p < end && (*p == '-' || *p == '+') )
+        {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        if( p >= end || !IsDigit(*p) )
+            return false;
+
+        long long result = 0;
+        for( ; p < end && IsDigit(*p); ++p )
+            result = result * 10 + (*p - '0');
+
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // One face corner : v, v/vt, v//vn or v/vt/vn. Only position index is kept.
+    bool ScanFaceIndex( const char *&p, const char *end, long long &vertexIndex )
+    {
+        SkipSpaces( p, end );
+        if( !ScanInt( p, end, vertexIndex ) )
+            return false;
+
+        long long ignored;
+        for( int slash = 0; slash < 2 && p < end && *p == '/'; ++slash )
+        {
+            ++p;
+            ScanInt( p, end, ignored );
+        }
+        return true;
+    }
+
+    inline const char *NextLine( const char *p, const char *end )
+    {
+        const char *newLine = static_cast<const char *>( memchr( p, '\n', static_cast<size_t>(end - p) ) );
+        return newLine ? newLine + 1 : end;
+    }
+}
+
 OBJReader::OBJReader()
 {
     initData();
@@ -34,7 +172,7 @@ void OBJReader::initData()
 /////////////////////////////////////////////
 /////////////////////////////////////////////
 double OBJReader::ReadOBJFile(std::string filepath, Mesh *pMesh,
-        OBJReader::ReadMethod r, GLboolean bFlipNormals)
+        OBJReader::ReadMethod r, GLboolean bFlipNormals, JobSystem *jobSystem)
 {
     int rFlag = -1;
 
@@ -45,6 +183,10 @@ double OBJReader::ReadOBJFile(std::string filepath, Mesh *pMesh,
 
 //    clock_t  startTime, endTime;
 
+    // no pool to split the file over, same parse on this thread
+    if( r == OBJReader::PARALLEL_MEMORY_MAPPED && !jobSystem )
+        r = OBJReader::MEMORY_MAPPED;
+
     auto startTime = std::chrono::high_resolution_clock::now();
 
     switch( r )
@@ -57,6 +199,14 @@ double OBJReader::ReadOBJFile(std::string filepath, Mesh *pMesh,
             rFlag = ReadOBJFile_BlockIO( filepath );
             break;
 
+        case OBJReader::MEMORY_MAPPED:
+            rFlag = ReadOBJFile_MemoryMapped( filepath );
+            break;
+
+        case OBJReader::PARALLEL_MEMORY_MAPPED:
+            rFlag = ReadOBJFile_ParallelMapped( filepath, *jobSystem );
+            break;
+
         default:
         std::cout << "Unknown value for OBJReader::ReadMethod in function ReadObjFile." << std::endl;
         std::cout << "Quitting ..." << std::endl;
@@ -74,7 +224,7 @@ double OBJReader::ReadOBJFile(std::string filepath, Mesh *pMesh,
 
 
     // Now calculate vertex normals
-    _currentMesh->calcVertexNormals(bFlipNormals);
+    _currentMesh->calcVertexNormals(bFlipNormals, Mesh::ANGLE_WEIGHTED, jobSystem);
     _currentMesh->calcUVs(Mesh::CYLINDRICAL_UV);
 
     return timeDuration;
@@ -178,6 +328,221 @@ int OBJReader::ReadOBJFile_BlockIO( std::string filepath )
     return rFlag;
 }
 
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Map the whole file and parse it in place, no copies of lines and no size limit
+int OBJReader::ReadOBJFile_MemoryMapped( std::string filepath )
+{
+    int rFlag = -1;
+
+    MappedFile file( filepath );
+    if( !file.IsOpen() )
+    {
+        std::cout << " Error mapping file " << filepath << std::endl;
+        return rFlag;
+    }
+
+    OBJChunk chunk;
+    ParseOBJChunk( file.GetData(), file.GetData() + file.GetSize(), chunk );
+
+    _currentMesh->vertexBuffer.swap( chunk.vertices );
+    _currentMesh->vertexNormals.swap( chunk.normals );
+
+    // single chunk starts at vertex 0, relative indices need no offset
+    _currentMesh->vertexIndices.assign( chunk.indices.begin(), chunk.indices.end() );
+
+    _currentMesh->boundingBox[0] = chunk.min;
+    _currentMesh->boundingBox[1] = chunk.max;
+
+    rFlag = 0;
+    return rFlag;
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+int OBJReader::ReadOBJFile_ParallelMapped( std::string filepath, JobSystem &jobSystem )
+{
+    int rFlag = -1;
+
+    MappedFile file( filepath );
+    if( !file.IsOpen() )
+    {
+        std::cout << " Error mapping file " << filepath << std::endl;
+        return rFlag;
+    }
+
+    const char *data = file.GetData();
+    const char *dataEnd = data + file.GetSize();
+
+    // at least 4MB per chunk, a few chunks per thread for load balance
+    const size_t minChunkSize = 4 * 1024 * 1024;
+    const size_t threadCount = jobSystem.GetThreadCount() + 1;
+    const size_t chunkCount = std::max<size_t>( 1, std::min( threadCount * 4, file.GetSize() / minChunkSize ) );
+
+    // chunk boundaries moved forward to the next line start
+    std::vector<const char *> bounds( chunkCount + 1 );
+    bounds[0] = data;
+    bounds[chunkCount] = dataEnd;
+    for( size_t i = 1; i < chunkCount; ++i )
+    {
+        const char *split = data + file.GetSize() / chunkCount * i;
+        bounds[i] = std::max( bounds[i - 1], NextLine( split, dataEnd ) );
+    }
+
+    std::vector<OBJChunk> chunks( chunkCount );
+
+    jobSystem.ParallelFor( static_cast<unsigned>(chunkCount), [&chunks, &bounds]( unsigned i )
+    {
+        ParseOBJChunk( bounds[i], bounds[i + 1], chunks[i] );
+    } );
+
+    // exclusive prefix sums : where each chunk's records go in the merged arrays
+    std::vector<size_t> vertexOffsets( chunkCount + 1, 0 );
+    std::vector<size_t> normalOffsets( chunkCount + 1, 0 );
+    std::vector<size_t> indexOffsets( chunkCount + 1, 0 );
+
+    glm::vec3 min( FLT_MAX, FLT_MAX, FLT_MAX );
+    glm::vec3 max( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+    for( size_t i = 0; i < chunkCount; ++i )
+    {
+        vertexOffsets[i + 1] = vertexOffsets[i] + chunks[i].vertices.size();
+        normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+        indexOffsets[i + 1] = indexOffsets[i] + chunks[i].indices.size();
+
+        if( !chunks[i].vertices.empty() )
+        {
+            min = glm::min( min, chunks[i].min );
+            max = glm::max( max, chunks[i].max );
+        }
+    }
+
+    _currentMesh->vertexBuffer.resize( vertexOffsets[chunkCount] );
+    _currentMesh->vertexNormals.resize( normalOffsets[chunkCount] );
+    _currentMesh->vertexIndices.resize( indexOffsets[chunkCount] );
+
+    Mesh *mesh = _currentMesh;
+
+    jobSystem.ParallelFor( static_cast<unsigned>(chunkCount),
+        [mesh, &chunks, &vertexOffsets, &normalOffsets, &indexOffsets]( unsigned i )
+    {
+        OBJChunk &chunk = chunks[i];
+
+        std::copy( chunk.vertices.begin(), chunk.vertices.end(), mesh->vertexBuffer.begin() + vertexOffsets[i] );
+        std::copy( chunk.normals.begin(), chunk.normals.end(), mesh->vertexNormals.begin() + normalOffsets[i] );
+
+        GLuint *out = mesh->vertexIndices.data() + indexOffsets[i];
+        std::copy( chunk.indices.begin(), chunk.indices.end(), out );
+
+        // relative indices were resolved against the chunk's own vertices
+        const GLint base = static_cast<GLint>( vertexOffsets[i] );
+        for( size_t slot : chunk.relativeSlots )
+            out[slot] = static_cast<GLuint>( base + chunk.indices[slot] );
+
+        std::vector<glm::vec3>().swap( chunk.vertices );
+        std::vector<GLint>().swap( chunk.indices );
+    } );
+
+    _currentMesh->boundingBox[0] = min;
+    _currentMesh->boundingBox[1] = max;
+
+    std::cout << "Parsed " << chunkCount << " chunks on " << threadCount << " threads." << std::endl;
+
+    rFlag = 0;
+    return rFlag;
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+void OBJReader::ParseOBJChunk( const char *begin, const char *end, OBJChunk &chunk )
+{
+    chunk.min = glm::vec3( FLT_MAX, FLT_MAX, FLT_MAX );
+    chunk.max = glm::vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+    // rough reservation : a vertex / face line is at least ~20 bytes
+    const size_t estimate = static_cast<size_t>(end - begin) / 40;
+    chunk.vertices.reserve( estimate );
+    chunk.indices.reserve( estimate * 3 );
+
+    const char *p = begin;
+
+    while( p < end )
+    {
+        const char *lineEnd = NextLine( p, end );
+        SkipSpaces( p, lineEnd );
+
+        if( p + 1 < lineEnd && p[0] == 'v' && IsSpace(p[1]) )
+        {
+            ++p;
+            glm::vec3 v( 0.f );
+            ScanFloat( p, lineEnd, v.x );
+            ScanFloat( p, lineEnd, v.y );
+            ScanFloat( p, lineEnd, v.z );
+
+            chunk.min = glm::min( chunk.min, v );
+            chunk.max = glm::max( chunk.max, v );
+            chunk.vertices.push_back( v );
+        }
+        else if( p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]) )
+        {
+            p += 2;
+            glm::vec3 n( 0.f );
+            ScanFloat( p, lineEnd, n.x );
+            ScanFloat( p, lineEnd, n.y );
+            ScanFloat( p, lineEnd, n.z );
+
+            chunk.normals.push_back( glm::normalize(n) );
+        }
+        else if( p + 1 < lineEnd && p[0] == 'f' && IsSpace(p[1]) )
+        {
+            ++p;
+
+            // fan triangulation of polygon, same as ParseOBJRecord
+            GLint corners[3];
+            bool relative[3];
+            int cornerCount = 0;
+            long long index;
+
+            while( ScanFaceIndex( p, lineEnd, index ) )
+            {
+                const bool isRelative = index < 0;
+                const GLint value = static_cast<GLint>( isRelative
+                    ? static_cast<long long>(chunk.vertices.size()) + index
+                    : index - 1 );
+
+                if( cornerCount < 3 )
+                {
+                    corners[cornerCount] = value;
+                    relative[cornerCount] = isRelative;
+                    ++cornerCount;
+                }
+                else
+                {
+                    corners[1] = corners[2];
+                    relative[1] = relative[2];
+                    corners[2] = value;
+                    relative[2] = isRelative;
+                }
+
+                if( cornerCount == 3 )
+                {
+                    for( int corner = 0; corner < 3; ++corner )
+                    {
+                        if( relative[corner] )
+                            chunk.relativeSlots.push_back( chunk.indices.size() );
+                        chunk.indices.push_back( corners[corner] );
+                    }
+                }
+            }
+        }
+
+        p = lineEnd;
+    }
+}
+
 /////////////////////////////////////////////
 /////////////////////////////////////////////
 /////////////////////////////////////////////
@@ -27,20 +27,45 @@ public:
 
 
     // Read data from a file
-    enum ReadMethod { LINE_BY_LINE, BLOCK_IO };
+    enum ReadMethod { LINE_BY_LINE, BLOCK_IO, MEMORY_MAPPED, PARALLEL_MEMORY_MAPPED };
+    // jobSystem : app's worker pool, PARALLEL_MEMORY_MAPPED without one reads on this thread
     double ReadOBJFile(std::string filepath,
                        Mesh *pMesh,
                        ReadMethod r = ReadMethod::LINE_BY_LINE,
-                       GLboolean bFlipNormals = false);
+                       GLboolean bFlipNormals = false,
+                       JobSystem *jobSystem = nullptr);
 
 private:
 
+    // Parsed records of a range of the file.
+    // Face indices are 0-based. Relative (negative) OBJ indices are stored as position
+    // among the chunk's own vertices (may be negative), listed in relativeSlots,
+    // and get the chunk's vertex offset added when merged.
+    struct OBJChunk
+    {
+        std::vector<glm::vec3>  vertices;
+        std::vector<glm::vec3>  normals;
+        std::vector<GLint>      indices;
+        std::vector<size_t>     relativeSlots;
+        glm::vec3               min, max;
+    };
+
     // Read OBJ file line by line
     int ReadOBJFile_LineByLine( std::string filepath );
 
     // Read the OBJ file in blocks -- works for files smaller than 1GB
     int ReadOBJFile_BlockIO( std::string filepath );
 
+    // Map the file and parse it in place -- no size limit, supports v/vt/vn faces
+    int ReadOBJFile_MemoryMapped( std::string filepath );
+
+    // Same as above, file split at line boundaries and chunks parsed on all cores,
+    // then merged with prefix sum offsets
+    int ReadOBJFile_ParallelMapped( std::string filepath, JobSystem &jobSystem );
+
+    // Parse [begin, end) of mapped file, end must be on a line boundary
+    static void ParseOBJChunk( const char *begin, const char *end, OBJChunk &chunk );
+
     // Parse individual OBJ record (one line delimited by '\n')
     void ParseOBJRecord( char *buffer, glm::vec3 &min, glm::vec3 &max );
 
@@ -7,11 +7,13 @@
 #include "Object.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include "AnimationBlender.h"
 #include "AnimationModel.h"
 
 Object::Object(AnimationModel* model, glm::vec3 posVal, glm::vec3 rotVal, glm::vec3 scaleVal)
 {
 	animationModel = model;
+	blender = new AnimationBlender(model);
 	pos = posVal;
 	rot = rotVal;
 	scale = scaleVal;
@@ -19,6 +21,7 @@ Object::Object(AnimationModel* model, glm::vec3 posVal, glm::vec3 rotVal, glm::v
 
 Object::~Object()
 {
+	delete blender;
 }
 
 glm::mat4 Object::GetModelMatrix()
@@ -61,6 +64,14 @@ void Object::Draw(
 		animationIndex);
 }
 
+void Object::DrawPose(
+	const glm::mat4& projViewMat, float animationT, int transformsOffset,
+	const glm::mat4* transforms, unsigned transformsCount)
+{
+	animationModel->DrawPose(GetModelMatrix(), projViewMat, animationT, transformsOffset,
+		transforms, transformsCount);
+}
+
 std::chrono::system_clock::time_point Object::GetAnimationStartTime() const
 {
 	return animationModel->startTime;
@@ -11,6 +11,7 @@
 
 
 struct aiScene;
+class AnimationBlender;
 class AnimationModel;
 
 class Object
@@ -22,9 +23,13 @@ public:
 	void Draw(
 		const glm::mat4& projViewMat, float animationT, int transformsOffset,
 		unsigned animationIndex);
+	void DrawPose(
+		const glm::mat4& projViewMat, float animationT, int transformsOffset,
+		const glm::mat4* transforms, unsigned transformsCount);
 	std::chrono::system_clock::time_point GetAnimationStartTime() const;
 	void ResetAnimationStartTime();
 	AnimationModel* animationModel;
+	AnimationBlender* blender;
 	glm::vec3 pos, rot, scale;
 	glm::vec3 W, U, V;
 private:
@@ -0,0 +1,164 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-11-07
+ * Description	: Many movers on one Line, kept as arrays (one entry per agent) instead of objects.
+ */
+
+#include "PathAgents.h"
+
+#include <cmath>
+#include <glm/geometric.hpp>
+
+#include "CatmullRomPath.h"
+#include "JobSystem.h"
+#include "Line.h"
+
+namespace
+{
+	//agents per job, each stage runs over the whole block before the next one
+	const size_t agentsPerBlock = 256;
+}
+
+PathAgents::PathAgents(const Line* line_, JobSystem* jobSystem_)
+	: line(line_), jobSystem(jobSystem_)
+{
+}
+
+PathAgents::~PathAgents()
+= default;
+
+unsigned PathAgents::AddAgent(float period, float timeOffset, float easeIn, float easeOut, float scale)
+{
+	times.push_back(timeOffset - std::floor(timeOffset));
+	inversePeriods.push_back(period > 0.f ? 1.f / period : 0.f);
+	easeIns.push_back(easeIn);
+	easeOuts.push_back(easeOut);
+	scales.push_back(scale);
+
+	distances.push_back(0.f);
+	params.push_back(0.f);
+
+	return static_cast<unsigned>(times.size() - 1);
+}
+
+void PathAgents::Clear()
+{
+	times.clear();
+	inversePeriods.clear();
+	easeIns.clear();
+	easeOuts.clear();
+	scales.clear();
+	distances.clear();
+	params.clear();
+}
+
+float PathAgents::EaseDistance(float t, float easeIn, float easeOut)
+{
+	const float PI = 3.14159265359f;
+
+	const float k1 = easeIn;
+	const float k2 = easeOut;
+
+	const float f = k1 * 2.f / PI + k2 - k1 + (1.f - k2) * 2.f / PI;
+
+	float s;
+
+	if (t < k1)
+		s = k1 * (2.f / PI) * (std::sin(t / k1 * PI / 2.f - PI / 2.f) + 1.f);
+	else if (t < k2)
+		s = 2.f * k1 / PI + t - k1;
+	else
+		s = 2.f * k1 / PI + k2 - k1 + ((1.f - k2) * (2.f / PI)) *
+		std::sin((t - k2) / (1.f - k2) * PI / 2.f);
+
+	return s / f;
+}
+
+void PathAgents::Update(float dt, glm::mat4* worlds, size_t strideBytes)
+{
+	const size_t count = times.size();
+	if (count == 0)
+		return;
+
+	//every point removed, nothing to follow, matrices stay as they were
+	if (line->GetPath().GetSegmentCount() == 0)
+		return;
+
+	unsigned char* out = reinterpret_cast<unsigned char*>(worlds);
+	const unsigned blockCount = static_cast<unsigned>((count + agentsPerBlock - 1) / agentsPerBlock);
+
+	auto job = [this, count, dt, out, strideBytes](unsigned block)
+	{
+		const size_t begin = block * agentsPerBlock;
+		const size_t end = begin + agentsPerBlock < count ? begin + agentsPerBlock : count;
+
+		UpdateRange(begin, end, dt, out, strideBytes);
+	};
+
+	if (jobSystem)
+		jobSystem->ParallelFor(blockCount, job);
+	else
+	{
+		for (unsigned i = 0; i < blockCount; ++i)
+			job(i);
+	}
+}
+
+void PathAgents::UpdateRange(size_t begin, size_t end, float dt, unsigned char* worlds, size_t strideBytes)
+{
+	float* time = times.data();
+	float* distance = distances.data();
+	float* param = params.data();
+	const float* inversePeriod = inversePeriods.data();
+	const float* easeIn = easeIns.data();
+	const float* easeOut = easeOuts.data();
+
+	//advance time, wrap to [0, 1)
+	for (size_t i = begin; i < end; ++i)
+	{
+		const float t = time[i] + dt * inversePeriod[i];
+		time[i] = t - std::floor(t);
+	}
+
+	for (size_t i = begin; i < end; ++i)
+		distance[i] = EaseDistance(time[i], easeIn[i], easeOut[i]);
+
+	//normalized distance -> normalized path parameter, one index and lerp each
+	line->GetParams(distance + begin, param + begin, end - begin);
+
+	const CatmullRomPath& path = line->GetPath();
+	const float segmentCount = static_cast<float>(path.GetSegmentCount());
+	const unsigned lastSegment = path.GetSegmentCount() - 1;
+	const glm::vec3 worldUp(0.f, 1.f, 0.f);
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		const float u = param[i] * segmentCount;
+		unsigned segment = static_cast<unsigned>(u);
+		if (segment > lastSegment)
+			segment = lastSegment;
+
+		const float t = u - static_cast<float>(segment);
+
+		const CubicSpline& spline = path.GetSegment(segment);
+		const glm::vec3 position = spline.Interpolate(t);
+		const glm::vec3 derivative = spline.InterpolateDerivative(t);
+
+		//forward along the path, y up as much as the tangent allows
+		const float derivativeLength = glm::length(derivative);
+		const glm::vec3 forward = derivativeLength > 0.f ? derivative / derivativeLength : glm::vec3(0.f, 0.f, 1.f);
+
+		glm::vec3 right = glm::cross(worldUp, forward);
+		const float rightLength = glm::length(right);
+		right = rightLength > 1e-6f ? right / rightLength : glm::vec3(1.f, 0.f, 0.f);
+
+		const glm::vec3 up = glm::cross(forward, right);
+		const float scale = scales[i];
+
+		glm::mat4& world = *reinterpret_cast<glm::mat4*>(worlds + i * strideBytes);
+		world[0] = glm::vec4(right * scale, 0.f);
+		world[1] = glm::vec4(up * scale, 0.f);
+		world[2] = glm::vec4(forward * scale, 0.f);
+		world[3] = glm::vec4(position, 1.f);
+	}
+}
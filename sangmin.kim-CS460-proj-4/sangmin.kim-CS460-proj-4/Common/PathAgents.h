@@ -0,0 +1,55 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-11-07
+ * Description	: Many movers on one Line, kept as arrays (one entry per agent) instead of objects.
+ *                Update advances all of them in passes over the arrays:
+ *                time -> eased distance -> path parameter (Line's inverse arc length table)
+ *                -> position, tangent frame -> world matrix written into caller's buffer.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+class JobSystem;
+class Line;
+
+class PathAgents
+{
+public:
+	PathAgents(const Line* line_, JobSystem* jobSystem_ = nullptr);
+	~PathAgents();
+
+	//period : seconds for one trip, easeIn / easeOut : fraction of trip spent speeding up / until slowing down
+	unsigned AddAgent(float period, float timeOffset = 0.f, float easeIn = 0.3f, float easeOut = 0.7f, float scale = 1.f);
+	void Clear();
+	size_t GetCount() const { return times.size(); }
+
+	/*
+	 * Write world matrix of every agent to worlds, strideBytes apart,
+	 * so it can point straight into an instance array (e.g. BakedCrowd::instances[0].world).
+	 */
+	void Update(float dt, glm::mat4* worlds, size_t strideBytes = sizeof(glm::mat4));
+
+	//same curve as Graphic::DistanceTimeFunction, t and result in [0, 1]
+	static float EaseDistance(float t, float easeIn, float easeOut);
+
+	//per agent, normalized trip time
+	std::vector<float> times;
+	std::vector<float> inversePeriods;
+	std::vector<float> easeIns;
+	std::vector<float> easeOuts;
+	std::vector<float> scales;
+
+private:
+	void UpdateRange(size_t begin, size_t end, float dt, unsigned char* worlds, size_t strideBytes);
+
+	const Line* line;
+	JobSystem* jobSystem;
+
+	//scratch, one entry per agent
+	std::vector<float> distances;
+	std::vector<float> params;
+};
@@ -6,14 +6,18 @@
 
 #include "PhysicsSimulation.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include "ClothUpsampler.h"
+#include "GridCloth.h"
 #include "massspringsystem.h"
 
-PhysicsSimulation::PhysicsSimulation(Shader* dotShader_, Shader* lineShader_)
+PhysicsSimulation::PhysicsSimulation(Shader* dotShader_, Shader* lineShader_, JobSystem* jobSystem_)
 {
     dotShader = dotShader_;
     lineShader = lineShader_;
+    jobSystem = jobSystem_;
     width = 75;
     height = 75;
     y = 10;
@@ -25,47 +29,107 @@ PhysicsSimulation::PhysicsSimulation(Shader* dotShader_, Shader* lineShader_)
 PhysicsSimulation::~PhysicsSimulation()
 {
     delete simSystem;
+    delete gridCloth;
+    delete upsampler;
 }
 
 void PhysicsSimulation::SetVariables()
 {
-    massValue = 0.05f;
-    springConstantValue = 1.f;
-    dampingConstantValue = 0.05f;
-    restLengthValue = 0.05f;
+    defaultMaterial.mass = 0.05f;
+    defaultMaterial.springConstant = 1.f;
+    defaultMaterial.dampingConstant = 0.05f;
+    defaultMaterial.restLength = 0.05f;
 }
 
-void PhysicsSimulation::InitializeSimulation(glm::vec3 leftFront, glm::vec3 leftBack, glm::vec3 rightFront)
+/*
+ * Tuned materials survive resets, only region count changes recreate them.
+ */
+void PhysicsSimulation::SetRegionMaterials(std::vector<ClothMaterial>& materials) const
 {
-    delete simSystem;
-    simSystem = new MassSpringSystem(dotShader, lineShader);
+    const int regionCount = materialRegionCount < 1 ? 1 : (materialRegionCount > simHeight ? simHeight : materialRegionCount);
 
-    
+    if (static_cast<int>(materials.size()) != regionCount)
+        materials.assign(regionCount, defaultMaterial);
+}
+
+void PhysicsSimulation::InitializeSimulation(glm::vec3 leftFront, glm::vec3 leftBack, glm::vec3 rightFront)
+{
     const float xStep = (rightFront.x - leftFront.x) / static_cast<float>(width);
     const float zStep = (rightFront.z - leftBack.z) / static_cast<float>(height);
 
+    gridActive = useGridKernel;
+    multiResolutionActive = gridActive && multiResolution && refinement > 1;
+    springLengthsValid = false;
+    stableStepMaterials.clear();
+
+    //coarse grid with the same extent, the upsampler brings it back to about width x height
+    simWidth = multiResolutionActive ? std::max(2, (width - 1) / refinement + 1) : width;
+    simHeight = multiResolutionActive ? std::max(2, (height - 1) / refinement + 1) : height;
+
+    leftBackIndex = 0;
+    rightBackIndex = simWidth - 1;
+    leftFrontIndex = (simHeight - 1) * simWidth;
+    rightFrontIndex = (simHeight - 1) * simWidth + simWidth - 1;
+
+    if (gridActive)
+        InitializeGridCloth(leftBack, xStep, zStep);
+    else
+        InitializeSpringSystem(leftBack, xStep, zStep);
+}
+
+void PhysicsSimulation::InitializeGridCloth(glm::vec3 leftBack, float xStep, float zStep)
+{
+    if (gridCloth == nullptr)
+        gridCloth = new GridCloth(dotShader, lineShader);
+
+    SetRegionMaterials(gridCloth->materials);
+
+    const int regionCount = static_cast<int>(gridCloth->materials.size());
+    //coarsening differs per direction when width != height or (size - 1) isn't a multiple of refinement
+    const float xScale = static_cast<float>(width - 1) / static_cast<float>(simWidth - 1);
+    const float zScale = static_cast<float>(height - 1) / static_cast<float>(simHeight - 1);
+
+    gridCloth->SetResolutionScale(xScale, zScale);
+    gridCloth->Initialize(simWidth, simHeight, glm::vec3(leftBack.x, static_cast<float>(y), leftBack.z),
+        xStep * xScale, zStep * zScale);
+
+    for (int i = 0; i < simHeight; ++i)
+        gridCloth->rowMaterials[i] = static_cast<unsigned>(i * regionCount / simHeight);
+
+    if (multiResolutionActive)
+    {
+        if (upsampler == nullptr)
+            upsampler = new ClothUpsampler(dotShader, lineShader);
+
+        upsampler->Initialize(simWidth, simHeight, refinement);
+        UpsampleFine(nullptr);
+    }
+
+    gridCloth->SetFixed(leftBackIndex, true);
+    gridCloth->SetFixed(leftFrontIndex, true);
+    gridCloth->SetFixed(rightFrontIndex, true);
+    gridCloth->SetFixed(rightBackIndex, true);
+}
+
+void PhysicsSimulation::InitializeSpringSystem(glm::vec3 leftBack, float xStep, float zStep)
+{
+    //same grid again : reuse masses, springs and buffers of the previous run
+    if (simSystem)
+        simSystem->Reset();
+    else
+        simSystem = new MassSpringSystem(dotShader, lineShader);
+
+    SetRegionMaterials(simSystem->materials);
+
+    const int regionCount = static_cast<int>(simSystem->materials.size());
+
     float z = leftBack.z;
     for (int i = 0; i < height; ++i) 
     {
         float x = leftBack.x;
         for (int j = 0; j < width; ++j)
         {
-            //right back
-            if(i == 0 && j == width - 1)
-            {
-                rightBackIndex = i * width + j;
-            }
-            //leftFront
-            else if(i == height - 1 && j == 0)
-            {
-                leftFrontIndex = i * width + j;
-            }
-            else if(i == height - 1 && j == width - 1)
-            {
-                rightFrontIndex = i * width + j;
-            }
-
-            simSystem->AddMass(massValue, x, (float)y, z);
+            simSystem->AddMass(static_cast<unsigned>(i * regionCount / height), x, (float)y, z);
             x = x + xStep;
         }
         z = z + zStep;
@@ -76,44 +140,292 @@ void PhysicsSimulation::InitializeSimulation(glm::vec3 leftFront, glm::vec3 left
     simSystem->masses[rightFrontIndex]->isFixedPosition = true;
     simSystem->masses[rightBackIndex]->isFixedPosition = true;
     
-    float k = springConstantValue;
-    float kd = dampingConstantValue;
-    float rl = restLengthValue;
-    const float rlLong = 1.4142f * rl;
+    const float rlLong = 1.4142f;
 
     for (int j = 0; j < height - 1; ++j) 
     {
         for (int i = 0; i < width - 1; ++i) 
         {
-	        const int mIndex = j * height + i;
-	        const int mRightIndex = j * height + (i + 1);
-	        const int mDownIndex = (j + 1) * height + i;
-	        const int mDownRightIndex = (j + 1) * height + (i + 1);
-
-            simSystem->AddSpring(k, rl, mIndex, mRightIndex, kd);
-            simSystem->AddSpring(k, rl, mIndex, mDownIndex, kd);
-            simSystem->AddSpring(k, rlLong, mIndex, mDownRightIndex, kd);
-            simSystem->AddSpring(k, rlLong, mRightIndex, mDownIndex, kd);
+	        const int mIndex = j * width + i;
+	        const int mRightIndex = j * width + (i + 1);
+	        const int mDownIndex = (j + 1) * width + i;
+	        const int mDownRightIndex = (j + 1) * width + (i + 1);
+            const unsigned material = simSystem->masses[mIndex]->material;
+
+            simSystem->AddSpring(material, 1.f, mIndex, mRightIndex);
+            simSystem->AddSpring(material, 1.f, mIndex, mDownIndex);
+            simSystem->AddSpring(material, rlLong, mIndex, mDownRightIndex);
+            simSystem->AddSpring(material, rlLong, mRightIndex, mDownIndex);
         }
     }
 
     //FreezeObjs(true);
 
     simSystem->Initializing();
+
+    if (reorderMasses)
+    {
+        const std::vector<int> newIndex = simSystem->ReorderMasses(massCurve);
+
+        leftBackIndex = newIndex[leftBackIndex];
+        leftFrontIndex = newIndex[leftFrontIndex];
+        rightFrontIndex = newIndex[rightFrontIndex];
+        rightBackIndex = newIndex[rightBackIndex];
+    }
+}
+
+std::vector<ClothMaterial>& PhysicsSimulation::GetMaterials()
+{
+    if (gridActive)
+        return gridCloth->materials;
+    return simSystem->materials;
 }
 
 void PhysicsSimulation::UpdateSimulation(float dt, SimpleBox* box)
 {
-    simSystem->update(dt, box);
+    rollbackCount = 0;
+
+    if (gridActive)
+        gridCloth->sleepTiles.enabled = allowSleeping;
+    else
+        simSystem->sleepTiles.enabled = allowSleeping;
+
+    if (!adaptiveStep || dt <= 0.f)
+    {
+        StepActive(dt, box);
+        springLengthsValid = false;
+        lastSubstepCount = 1;
+        UpsampleFine(box);
+        return;
+    }
+
+    //depends on materials only, which change from the UI now and then
+    if (stableStepMaterials.empty() || !(stableStepMaterials == GetMaterials()))
+    {
+        stableStepMaterials = GetMaterials();
+        cachedStableStep = GetStableStep();
+        //rest lengths come from the materials too
+        springLengthsValid = false;
+    }
+
+    const float minStep = dt / static_cast<float>(maxSubsteps);
+    const float stableStep = std::max(cachedStableStep, minStep);
+
+    float step = std::min(strainStep, stableStep);
+    float remaining = dt;
+    int substeps = 0;
+
+    //lengths after the last step are still valid unless anchors or materials changed since
+    if (!springLengthsValid)
+    {
+        if (gridActive)
+            gridCloth->GetSpringLengths(springLengths, springRestLengths);
+        else
+            simSystem->GetSpringLengths(springLengths, springRestLengths);
+        nextSpringLengths = springLengths;
+        springLengthsValid = true;
+    }
+
+    //box moves and material edits wake tiles now, before the awake ones are picked
+    GetSleepTiles().WakeOnChange(box, GetMaterials());
+
+    //at maxSubsteps the rest of the frame is dropped, the cloth runs slower instead of exploding
+    while (remaining > 0.f && substeps < maxSubsteps)
+    {
+        float h = std::min(step, remaining);
+        if (remaining - h < 0.5f * minStep)
+            h = remaining;
+
+        SelectStepTiles();
+        SaveState();
+        StepActive(h, box);
+
+        const float strainChange = GetMaxStrainChange();
+
+        //written this way so NaN counts as diverged
+        if (!(strainChange <= divergenceStrainChange))
+        {
+            ++rollbackCount;
+
+            if (h > minStep)
+            {
+                RestoreState(true);
+                step = std::max(h * 0.5f, minStep);
+                continue;
+            }
+
+            //diverges even at the smallest step : back to the last good positions, at rest
+            RestoreState(false);
+            break;
+        }
+
+        remaining -= h;
+        ++substeps;
+        for (unsigned spring : stepSprings)
+            springLengths[spring] = nextSpringLengths[spring];
+
+        if (strainChange > targetStrainChange)
+            step = std::max(h * targetStrainChange / strainChange, minStep);
+        else
+            step = std::min(step * 2.f, stableStep);
+    }
+
+    strainStep = step;
+    lastSubstepCount = substeps;
+
+    UpsampleFine(box);
+}
+
+/*
+ * Once per frame, not per step : only what is drawn needs the fine grid.
+ */
+void PhysicsSimulation::UpsampleFine(SimpleBox* box)
+{
+    if (!multiResolutionActive)
+        return;
+
+    upsampler->Upsample(gridCloth->px.data(), gridCloth->py.data(), gridCloth->pz.data());
+
+    if (fineDetail && box)
+        upsampler->ResolveBox(box);
+}
+
+void PhysicsSimulation::StepActive(float dt, SimpleBox* box)
+{
+    if (gridActive)
+    {
+        gridCloth->Update(dt, box);
+        if (strainLimiting)
+            gridCloth->LimitStrain(dt, maxStretch, strainIterations, jobSystem);
+    }
+    else
+    {
+        simSystem->update(dt, box);
+        if (strainLimiting)
+            simSystem->LimitStrain(dt, maxStretch, strainIterations, jobSystem);
+    }
+}
+
+/*
+ * Explicit springs are stable for dt < 2 / omega, omega^2 <= 2 * stiffness / mass
+ * (Gershgorin, equal masses), and the damping term for dt < 2 * mass / damping.
+ */
+float PhysicsSimulation::GetStableStep() const
+{
+    float stiffnessToMass, dampingToMass;
+    if (gridActive)
+        gridCloth->GetStiffnessRatios(stiffnessToMass, dampingToMass);
+    else
+        simSystem->GetStiffnessRatios(stiffnessToMass, dampingToMass);
+
+    float stableStep = 1.f;
+    if (stiffnessToMass > 0.f)
+        stableStep = std::min(stableStep, 2.f / std::sqrt(2.f * stiffnessToMass));
+    if (dampingToMass > 0.f)
+        stableStep = std::min(stableStep, 2.f / dampingToMass);
+
+    return stableStep * stepSafety;
+}
+
+SleepTiles& PhysicsSimulation::GetSleepTiles()
+{
+    if (gridActive)
+        return gridCloth->sleepTiles;
+    return simSystem->sleepTiles;
+}
+
+/*
+ * Sleeping tiles are not integrated, so a settled cloth saves and measures nothing.
+ * The strain limiter can pull masses of any tile once something moves, it is O(all) itself.
+ */
+void PhysicsSimulation::SelectStepTiles()
+{
+    const SleepTiles& sleepTiles = GetSleepTiles();
+    sleepTiles.GetAwakeTiles(stepTiles);
+
+    if (strainLimiting && !stepTiles.empty() && stepTiles.size() < sleepTiles.GetTileCount())
+    {
+        stepTiles.resize(sleepTiles.GetTileCount());
+        for (unsigned tile = 0; tile < sleepTiles.GetTileCount(); ++tile)
+            stepTiles[tile] = tile;
+    }
+
+    if (gridActive)
+        gridCloth->GetTileSprings(stepTiles, stepSprings);
+    else
+        simSystem->GetTileSprings(stepTiles, stepSprings);
+}
+
+void PhysicsSimulation::SaveState()
+{
+    if (gridActive)
+        gridCloth->SaveState(stepTiles, savedState);
+    else
+        simSystem->SaveState(stepTiles, savedState);
+}
+
+void PhysicsSimulation::RestoreState(bool keepVelocities)
+{
+    if (gridActive)
+        gridCloth->RestoreState(stepTiles, savedState, keepVelocities);
+    else
+        simSystem->RestoreState(stepTiles, savedState, keepVelocities);
+}
+
+float PhysicsSimulation::GetMaxStrainChange()
+{
+    if (gridActive)
+        gridCloth->GetSpringLengths(stepSprings, nextSpringLengths);
+    else
+        simSystem->GetSpringLengths(stepSprings, nextSpringLengths);
+
+    float maxChange = 0.f;
+
+    for (unsigned i : stepSprings)
+    {
+        const float change = std::abs(nextSpringLengths[i] - springLengths[i]) / springRestLengths[i];
+
+        if (!std::isfinite(change))
+            return INFINITY;
+
+        maxChange = std::max(maxChange, change);
+    }
+
+    return maxChange;
+}
+
+unsigned PhysicsSimulation::GetAwakeTileCount() const
+{
+    if (gridActive)
+        return gridCloth->sleepTiles.GetAwakeCount();
+    return simSystem ? simSystem->sleepTiles.GetAwakeCount() : 0;
+}
+
+unsigned PhysicsSimulation::GetTileCount() const
+{
+    if (gridActive)
+        return gridCloth->sleepTiles.GetTileCount();
+    return simSystem ? simSystem->sleepTiles.GetTileCount() : 0;
 }
 
 void PhysicsSimulation::Draw(glm::mat4 projViewMat)
 {
-    simSystem->draw(projViewMat);
+    if (multiResolutionActive)
+        upsampler->Draw(projViewMat);
+    else if (gridActive)
+        gridCloth->Draw(projViewMat);
+    else
+        simSystem->draw(projViewMat);
 }
 
 void PhysicsSimulation::FreezeObjs(bool toggle)
 {
+    if (gridActive)
+    {
+        gridCloth->SetAllFixed(toggle);
+        return;
+    }
+
     for(int i = 0; i < height; ++i)
     {
 	    for(int j = 0; j < width; ++j)
@@ -121,20 +433,29 @@ void PhysicsSimulation::FreezeObjs(bool toggle)
             simSystem->masses[i * width + j]->isFixedPosition = toggle;
 	    }
     }
+    simSystem->sleepTiles.WakeAll();
 }
 
 void PhysicsSimulation::SetAnchorPositions(glm::vec3 leftFront, glm::vec3 leftBack, glm::vec3 rightFront,
 	glm::vec3 rightBack)
 {
-    simSystem->massesPositions[leftBackIndex] = leftBack;
-    simSystem->masses[leftBackIndex]->position = leftBack;
-
-    simSystem->massesPositions[leftFrontIndex] = leftFront;
-    simSystem->masses[leftFrontIndex]->position = leftFront;
+    bool moved = false;
 
-    simSystem->massesPositions[rightFrontIndex] = rightFront;
-    simSystem->masses[rightFrontIndex]->position = rightFront;
+    if (gridActive)
+    {
+        moved |= gridCloth->SetPosition(leftBackIndex, leftBack);
+        moved |= gridCloth->SetPosition(leftFrontIndex, leftFront);
+        moved |= gridCloth->SetPosition(rightFrontIndex, rightFront);
+        moved |= gridCloth->SetPosition(rightBackIndex, rightBack);
+    }
+    else
+    {
+        moved |= simSystem->SetMassPosition(leftBackIndex, leftBack);
+        moved |= simSystem->SetMassPosition(leftFrontIndex, leftFront);
+        moved |= simSystem->SetMassPosition(rightFrontIndex, rightFront);
+        moved |= simSystem->SetMassPosition(rightBackIndex, rightBack);
+    }
 
-    simSystem->massesPositions[rightBackIndex] = rightBack;
-    simSystem->masses[rightBackIndex]->position = rightBack;
+    if (moved)
+        springLengthsValid = false;
 }
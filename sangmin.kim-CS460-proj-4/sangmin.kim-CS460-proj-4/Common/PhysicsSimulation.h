@@ -11,14 +11,22 @@ class Spring;
 class PointMass;
 class Shader;
 class MassSpringSystem;
+class GridCloth;
+class ClothUpsampler;
+class JobSystem;
 
+#include <vector>
 #include "glm/mat4x4.hpp"
+#include "ClothMaterial.h"
+#include "SleepTiles.h"
+#include "SpaceFillingCurve.h"
 
 
 class PhysicsSimulation
 {
 public:
-	PhysicsSimulation(Shader* dotShader_, Shader* lineShader_);
+	//jobSystem_ (optional) runs the strain limiting sweeps
+	PhysicsSimulation(Shader* dotShader_, Shader* lineShader_, JobSystem* jobSystem_ = nullptr);
 	~PhysicsSimulation();
     void SetVariables();
     void InitializeSimulation(glm::vec3 leftFront, glm::vec3 leftBack, glm::vec3 rightFront);
@@ -26,20 +34,90 @@ public:
     void Draw(glm::mat4 projViewMat);
     void FreezeObjs(bool toggle);
     void SetAnchorPositions(glm::vec3 leftFront, glm::vec3 leftBack, glm::vec3 rightFront, glm::vec3 rightBack);
-    float massValue;
-    float springConstantValue;
-    float dampingConstantValue;
-    float restLengthValue;
+    //live material of each region, edits apply on the next update without a rebuild
+    std::vector<ClothMaterial>& GetMaterials();
+    //used when regions are (re)created
+    ClothMaterial defaultMaterial;
+    //rows of the cloth are split into this many regions, each with its own material
+    int materialRegionCount = 1;
+    //regular grid : stencil kernel without springs (GridCloth), else explicit masses and springs
+    bool useGridKernel = true;
+    //spring cloth only : renumber masses along massCurve after they are built
+    bool reorderMasses = false;
+    SpaceFillingCurve::Curve massCurve = SpaceFillingCurve::HILBERT;
+    //settled tiles stop being integrated until something disturbs them
+    bool allowSleeping = true;
+    //awake / all sleeping tiles of the active cloth
+    unsigned GetAwakeTileCount() const;
+    unsigned GetTileCount() const;
+    //split each frame into explicit steps below the stable step, roll back steps that diverge
+    bool adaptiveStep = true;
+    //fraction of the estimated stable step that is used
+    float stepSafety = 0.5f;
+    int maxSubsteps = 32;
+    //largest spring length change of one step, in rest lengths : above target the next step shrinks,
+    //above divergence the step is rolled back and retried with half the step
+    float targetStrainChange = 2.f;
+    float divergenceStrainChange = 10.f;
+    //after each step springs are pulled back to at most (1 + maxStretch) of their built length,
+    //so soft springs still give cloth that doesn't stretch
+    bool strainLimiting = false;
+    float maxStretch = 0.1f;
+    int strainIterations = 4;
+    //grid kernel only : simulate a grid refinement times coarser and draw a Catmull-Rom
+    //upsampled grid of about width x height, fineDetail also keeps fine vertices out of the box
+    bool multiResolution = false;
+    int refinement = 3;
+    bool fineDetail = true;
+    //last frame, for the UI
+    int lastSubstepCount = 0;
+    unsigned rollbackCount = 0;
 private:
+    void SetRegionMaterials(std::vector<ClothMaterial>& materials) const;
+    void InitializeSpringSystem(glm::vec3 leftBack, float xStep, float zStep);
+    void InitializeGridCloth(glm::vec3 leftBack, float xStep, float zStep);
+    void StepActive(float dt, SimpleBox* box);
+    void UpsampleFine(SimpleBox* box);
+    float GetStableStep() const;
+    SleepTiles& GetSleepTiles();
+    //tiles the next step can change and springs touching them, the watchdog only looks at those
+    void SelectStepTiles();
+    void SaveState();
+    void RestoreState(bool keepVelocities);
+    //largest |length - previous length| / rest length over stepSprings, infinity when a length is not finite
+    float GetMaxStrainChange();
+
     MassSpringSystem* simSystem = nullptr;
+    GridCloth* gridCloth = nullptr;
+    ClothUpsampler* upsampler = nullptr;
+    //which one the last InitializeSimulation built
+    bool gridActive = false;
+    bool multiResolutionActive = false;
     Shader* dotShader;
     Shader* lineShader;
+    JobSystem* jobSystem;
     int leftBackIndex = 0;
     int leftFrontIndex = 0;
     int rightFrontIndex = 0;
     int rightBackIndex = 0;
 
+    //step size the strain control ended the last frame with, grows back by 2x per good step
+    float strainStep = 1.f;
+    float cachedStableStep = 1.f;
+    //materials cachedStableStep was computed for
+    std::vector<ClothMaterial> stableStepMaterials;
+    //springLengths match the current positions
+    bool springLengthsValid = false;
+    ClothSnapshot savedState;
+    std::vector<unsigned> stepTiles;
+    std::vector<unsigned> stepSprings;
+    std::vector<float> springLengths;
+    std::vector<float> nextSpringLengths;
+    std::vector<float> springRestLengths;
+
     int width, height;
+    //size of the simulated grid, coarser than width x height in multi resolution
+    int simWidth = 0, simHeight = 0;
     int y;
 
 };
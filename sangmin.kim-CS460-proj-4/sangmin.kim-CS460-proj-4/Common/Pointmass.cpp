@@ -9,44 +9,25 @@
 #include "SimpleBox.h"
 
 
-float dydx(float x, float y)
+PointMass::PointMass(unsigned materialIndex, float x, float y, float z)
 {
-    return (x - y) / 2.f;
+    Reset(materialIndex, x, y, z);
 }
 
-
-float rungeKutta(float x0, float y0, float dt)
+void PointMass::Reset(unsigned materialIndex, float x, float y, float z)
 {
-    float y = y0;
-    for (int i = 1; i <= 3; i++)
-    {
-        float k1 = dt * dydx(x0, y);
-        float k2 = dt * dydx(x0 + 0.5f * dt, y + 0.5f * k1);
-        float k3 = dt * dydx(x0 + 0.5f * dt, y + 0.5f * k2);
-        float k4 = dt * dydx(x0 + dt, y + k3);
-
-        y = y + (1.0f / 6.0f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
-
-        x0 = x0 + dt;
-    }
-
-    return y;
-}
-
-PointMass::PointMass(float m, float x, float y, float z)
-{
-    mass = m;
+    material = materialIndex;
     dscale = 0.5f;
     position = glm::vec3(x, y, z);
     velocity = glm::vec3(0.0, 0.0, 0.0);
     gravity = glm::vec3(0.0, -9.81f, 0.0);
     isFixedPosition = false;
-
+    springs.clear();
 }
 
-glm::vec3 PointMass::CalculateForces()
+glm::vec3 PointMass::CalculateForces(const ClothMaterial* materials)
 {
-    glm::vec3 fg = gravity * (mass / 2.f);
+    glm::vec3 fg = gravity * (materials[material].mass / 2.f);
 
 	glm::vec3 fs = glm::vec3(0.f, 0.f, 0.f);
     glm::vec3 fd = glm::vec3(0.f, 0.f, 0.f);
@@ -55,8 +36,10 @@ glm::vec3 PointMass::CalculateForces()
 
     for (unsigned i = 0; i < springsSize; ++i)
     {
-        fs += springs[i]->GetSpringForce(this);
-        fd += springs[i]->GetDampingForce();
+        const ClothMaterial& springMaterial = materials[springs[i]->material];
+
+        fs += springs[i]->GetSpringForce(this, springMaterial);
+        fd += springs[i]->GetDampingForce(springMaterial);
     }
 
     glm::vec3 force = fg + fs + fd;
@@ -64,7 +47,7 @@ glm::vec3 PointMass::CalculateForces()
 }
 
 void PointMass::update(float dt, std::vector<glm::vec3>& massPositions,
-    SimpleBox* box)
+    SimpleBox* box, const ClothMaterial* materials)
 {
     if (isFixedPosition)
 	    return;
@@ -72,7 +55,7 @@ void PointMass::update(float dt, std::vector<glm::vec3>& massPositions,
     if (CheckCollisionWithBox(box))
         return;
 
-    glm::vec3 acc = CalculateForces() / mass;
+    glm::vec3 acc = CalculateForces(materials) / materials[material].mass;
     CalcPosition(acc, dt, massPositions);
 }
 
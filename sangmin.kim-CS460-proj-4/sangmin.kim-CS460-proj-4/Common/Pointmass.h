@@ -10,26 +10,54 @@
 #include "glm/glm.hpp"
 #include "Spring.h"
 
+struct ClothMaterial;
 class SimpleBox;
 class Shader;
 class Spring;
 class Buffer;
 
+inline float dydx(float x, float y)
+{
+    return (x - y) / 2.f;
+}
+
+//shared with GridCloth kernels, inline so they can be unrolled there
+inline float rungeKutta(float x0, float y0, float dt)
+{
+    float y = y0;
+    for (int i = 1; i <= 3; i++)
+    {
+        float k1 = dt * dydx(x0, y);
+        float k2 = dt * dydx(x0 + 0.5f * dt, y + 0.5f * k1);
+        float k3 = dt * dydx(x0 + 0.5f * dt, y + 0.5f * k2);
+        float k4 = dt * dydx(x0 + dt, y + k3);
+
+        y = y + (1.0f / 6.0f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
+
+        x0 = x0 + dt;
+    }
+
+    return y;
+}
+
 class PointMass
 {
 public:
-    PointMass(float mass, float x, float y, float z);
+    PointMass(unsigned materialIndex, float x, float y, float z);
+    //reuse for new simulation, keeps springs capacity
+    void Reset(unsigned materialIndex, float x, float y, float z);
 
 
-    glm::vec3 CalculateForces();
+    glm::vec3 CalculateForces(const ClothMaterial* materials);
     void update(float dt, std::vector<glm::vec3>& massPositions,
-        SimpleBox* box);
+        SimpleBox* box, const ClothMaterial* materials);
     void CalcPosition(glm::vec3 acceleration, float dt,
         std::vector<glm::vec3>& massPositions);
     bool CheckCollisionWithBox(SimpleBox* box);
 
 
-    float mass; 
+    //index to MassSpringSystem::materials
+    unsigned material;
     float dscale;
     glm::vec3 position;
     glm::vec3 velocity;
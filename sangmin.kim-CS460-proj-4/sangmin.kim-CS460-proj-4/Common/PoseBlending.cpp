@@ -0,0 +1,164 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Functions for blend LocalPoses (SSE when available).
+ */
+
+#include "PoseBlending.h"
+
+#include <cmath>
+#include <glm/geometric.hpp>
+
+#include "AnimationSkeleton.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define POSE_BLENDING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const float slerpEpsilon = 0.0001f;
+
+	glm::vec4 Multiply(const glm::vec4& a, const glm::vec4& b)
+	{
+		return glm::vec4(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	}
+
+	glm::vec4 Conjugate(const glm::vec4& q)
+	{
+		return glm::vec4(-q.x, -q.y, -q.z, q.w);
+	}
+
+#ifdef POSE_BLENDING_SSE
+	inline __m128 Load(const glm::vec4& v)
+	{
+		return _mm_loadu_ps(&v.x);
+	}
+
+	inline void Store(glm::vec4& v, __m128 value)
+	{
+		_mm_storeu_ps(&v.x, value);
+	}
+
+	//dot product broadcast to all lanes
+	inline __m128 Dot4(__m128 a, __m128 b)
+	{
+		const __m128 product = _mm_mul_ps(a, b);
+		const __m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+
+	inline __m128 Lerp(__m128 a, __m128 b, __m128 factor)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), factor));
+	}
+
+	//flip b when quaternions are in opposite hemispheres
+	inline __m128 AlignHemisphere(__m128 a, __m128 b)
+	{
+		const __m128 negative = _mm_cmplt_ps(Dot4(a, b), _mm_setzero_ps());
+		return _mm_xor_ps(b, _mm_and_ps(negative, _mm_set1_ps(-0.f)));
+	}
+
+	inline __m128 Normalize(__m128 q)
+	{
+		const __m128 lengthSquared = Dot4(q, q);
+		const __m128 valid = _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps());
+		return _mm_and_ps(_mm_div_ps(q, _mm_sqrt_ps(lengthSquared)), valid);
+	}
+#endif
+}
+
+namespace PoseBlending
+{
+	glm::vec4 Nlerp(const glm::vec4& from, const glm::vec4& to, float factor)
+	{
+#ifdef POSE_BLENDING_SSE
+		const __m128 a = Load(from);
+		const __m128 b = AlignHemisphere(a, Load(to));
+
+		glm::vec4 result;
+		Store(result, Normalize(Lerp(a, b, _mm_set1_ps(factor))));
+		return result;
+#else
+		const glm::vec4 end = glm::dot(from, to) < 0.f ? -to : to;
+		const glm::vec4 result = from + (end - from) * factor;
+		const float length = glm::length(result);
+
+		return length > 0.f ? result / length : result;
+#endif
+	}
+
+	glm::vec4 Slerp(const glm::vec4& from, const glm::vec4& to, float factor)
+	{
+		float cosom = glm::dot(from, to);
+		const float sign = cosom < 0.f ? -1.f : 1.f;
+		cosom *= sign;
+
+		if (1.f - cosom <= slerpEpsilon)
+			return Nlerp(from, to, factor);
+
+		const float omega = acos(cosom);
+		const float sinom = sin(omega);
+		const float scaleFrom = sin((1.f - factor) * omega) / sinom;
+		const float scaleTo = sign * sin(factor * omega) / sinom;
+
+#ifdef POSE_BLENDING_SSE
+		glm::vec4 result;
+		Store(result, _mm_add_ps(_mm_mul_ps(Load(from), _mm_set1_ps(scaleFrom)),
+			_mm_mul_ps(Load(to), _mm_set1_ps(scaleTo))));
+		return result;
+#else
+		return from * scaleFrom + to * scaleTo;
+#endif
+	}
+
+	void BlendPose(const LocalPose& from, const LocalPose& to, float factor, LocalPose& out, bool useSlerp)
+	{
+		const size_t size = from.Size();
+		out.Resize(size);
+
+#ifdef POSE_BLENDING_SSE
+		const __m128 factorVec = _mm_set1_ps(factor);
+#endif
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (useSlerp)
+				out.rotations[i] = Slerp(from.rotations[i], to.rotations[i], factor);
+			else
+				out.rotations[i] = Nlerp(from.rotations[i], to.rotations[i], factor);
+
+#ifdef POSE_BLENDING_SSE
+			Store(out.translations[i], Lerp(Load(from.translations[i]), Load(to.translations[i]), factorVec));
+			Store(out.scales[i], Lerp(Load(from.scales[i]), Load(to.scales[i]), factorVec));
+#else
+			out.translations[i] = from.translations[i] + (to.translations[i] - from.translations[i]) * factor;
+			out.scales[i] = from.scales[i] + (to.scales[i] - from.scales[i]) * factor;
+#endif
+		}
+	}
+
+	void AddPose(LocalPose& base, const LocalPose& additive, const LocalPose& reference, float weight)
+	{
+		const glm::vec4 identity(0.f, 0.f, 0.f, 1.f);
+		const glm::vec4 one(1.f, 1.f, 1.f, 0.f);
+		const size_t size = base.Size();
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			const glm::vec4 delta = Multiply(Conjugate(reference.rotations[i]), additive.rotations[i]);
+			base.rotations[i] = glm::normalize(Multiply(base.rotations[i], Nlerp(identity, delta, weight)));
+
+			base.translations[i] += (additive.translations[i] - reference.translations[i]) * weight;
+
+			const glm::vec4 scaleRatio = additive.scales[i] / glm::max(reference.scales[i], glm::vec4(1e-6f));
+			base.scales[i] *= one + (scaleRatio - one) * weight;
+		}
+	}
+}
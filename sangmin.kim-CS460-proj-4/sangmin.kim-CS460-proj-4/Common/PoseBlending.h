@@ -0,0 +1,24 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Functions for blend LocalPoses (SSE when available).
+ *                Rotations use nlerp (or slerp), translations / scales use lerp.
+ */
+
+#pragma once
+
+#include <glm/vec4.hpp>
+
+struct LocalPose;
+
+namespace PoseBlending
+{
+	glm::vec4 Nlerp(const glm::vec4& from, const glm::vec4& to, float factor);
+	glm::vec4 Slerp(const glm::vec4& from, const glm::vec4& to, float factor);
+
+	//out may be same as from.
+	void BlendPose(const LocalPose& from, const LocalPose& to, float factor, LocalPose& out, bool useSlerp = false);
+
+	//Add (additive - reference) on top of base with weight.
+	void AddPose(LocalPose& base, const LocalPose& additive, const LocalPose& reference, float weight);
+}
@@ -0,0 +1,83 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for evaluate poses of all animating instances before drawing.
+ */
+
+#include "PoseEvaluator.h"
+
+#include "AnimatingFunctions.h"
+#include "AnimationBlender.h"
+#include "AnimationModel.h"
+#include "JobSystem.h"
+
+PoseEvaluator::PoseEvaluator(JobSystem* jobSystem_)
+{
+	jobSystem = jobSystem_;
+}
+
+PoseEvaluator::~PoseEvaluator()
+{
+}
+
+void PoseEvaluator::BeginFrame()
+{
+	requests.clear();
+	arenaSize = 0;
+}
+
+unsigned PoseEvaluator::Request(AnimationModel* model, float animationT, unsigned animationIndex)
+{
+	PoseRequest request{};
+	request.model = model;
+	request.blender = nullptr;
+	request.animationT = animationT;
+	request.animationIndex = animationIndex;
+	request.offset = arenaSize;
+	request.count = model->GetBoneCount();
+
+	arenaSize += request.count;
+	requests.push_back(request);
+
+	return static_cast<unsigned>(requests.size() - 1);
+}
+
+unsigned PoseEvaluator::Request(AnimationModel* model, AnimationBlender* blender, float animationT)
+{
+	const unsigned requestIndex = Request(model, animationT, 0);
+	requests[requestIndex].blender = blender;
+
+	return requestIndex;
+}
+
+void PoseEvaluator::Evaluate()
+{
+	if (arena.size() < arenaSize)
+		arena.resize(arenaSize);
+
+	glm::mat4* arenaData = arena.data();
+
+	jobSystem->ParallelFor(static_cast<unsigned>(requests.size()), [this, arenaData](unsigned i)
+		{
+			const PoseRequest& request = requests[i];
+
+			if (request.blender)
+			{
+				request.blender->Evaluate(request.animationT, arenaData + request.offset);
+				return;
+			}
+
+			AnimatingFunctions::AnimationMatrix::GetBoneTransforms(arenaData + request.offset,
+				request.animationT, request.model->GetScene(), request.model, request.animationIndex);
+		});
+}
+
+const glm::mat4* PoseEvaluator::GetTransforms(unsigned requestIndex) const
+{
+	return arena.data() + requests[requestIndex].offset;
+}
+
+unsigned PoseEvaluator::GetTransformsCount(unsigned requestIndex) const
+{
+	return requests[requestIndex].count;
+}
@@ -0,0 +1,47 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Class for evaluate poses of all animating instances before drawing.
+ *                Requests are sampled in parallel on JobSystem into one frame-local matrix arena.
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+class AnimationBlender;
+class AnimationModel;
+class JobSystem;
+
+struct PoseRequest
+{
+	AnimationModel* model;
+	AnimationBlender* blender;
+	float animationT;
+	unsigned animationIndex;
+	unsigned offset;
+	unsigned count;
+};
+
+class PoseEvaluator
+{
+public:
+	PoseEvaluator(JobSystem* jobSystem_);
+	~PoseEvaluator();
+
+	void BeginFrame();
+	unsigned Request(AnimationModel* model, float animationT, unsigned animationIndex);
+	unsigned Request(AnimationModel* model, AnimationBlender* blender, float animationT);
+	void Evaluate();
+
+	const glm::mat4* GetTransforms(unsigned requestIndex) const;
+	unsigned GetTransformsCount(unsigned requestIndex) const;
+
+private:
+	JobSystem* jobSystem;
+	std::vector<PoseRequest> requests;
+	//capacity is kept between frames, so no allocation after the first frames.
+	std::vector<glm::mat4> arena;
+	unsigned arenaSize = 0;
+};
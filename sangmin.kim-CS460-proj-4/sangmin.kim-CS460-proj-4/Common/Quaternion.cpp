@@ -93,6 +93,11 @@ glm::mat4 Quaternion::GetMatrix()
 	return resMatrix;
 }
 
+glm::vec4 Quaternion::GetVec4() const
+{
+	return glm::vec4(x, y, z, w);
+}
+
 Quaternion::~Quaternion()
 {
 
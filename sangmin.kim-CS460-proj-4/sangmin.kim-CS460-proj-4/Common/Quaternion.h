@@ -21,6 +21,7 @@ public:
 	Quaternion& operator=(const aiQuaternion& val);
 	void Normalize();
 	glm::mat4 GetMatrix();
+	glm::vec4 GetVec4() const;
 	~Quaternion();
 
 private:
@@ -113,7 +113,8 @@ void SimpleBox::Draw(const glm::mat4& projViewMat, Texture* texture)
 {
 	shader->Use();
 	glBindVertexArray(vao);
-	texture->Bind(GL_TEXTURE0);
+	if (texture)
+		texture->Bind(GL_TEXTURE0);
 	glm::mat4 projViewModelMat = projViewMat * GetModelMatrix();
 	shader->SendUniformMatGLM("projViewModelMat", projViewModelMat);
 
@@ -0,0 +1,131 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Sleeping state of cloth tiles (groups of masses).
+ */
+
+#include "SleepTiles.h"
+
+#include <algorithm>
+
+#include "SimpleBox.h"
+
+void SleepTiles::Reset(unsigned tileCount)
+{
+    calmSteps.assign(tileCount, 0);
+    disturbed.assign(tileCount, 0);
+
+    neighbours.resize(tileCount);
+    for (std::vector<unsigned>& tileNeighbours : neighbours)
+        tileNeighbours.clear();
+
+    hasLastState = false;
+}
+
+void SleepTiles::AddNeighbours(unsigned tileA, unsigned tileB)
+{
+    if (tileA == tileB)
+        return;
+
+    neighbours[tileA].push_back(tileB);
+    neighbours[tileB].push_back(tileA);
+}
+
+void SleepTiles::FinishNeighbours()
+{
+    for (std::vector<unsigned>& tileNeighbours : neighbours)
+    {
+        std::sort(tileNeighbours.begin(), tileNeighbours.end());
+        tileNeighbours.erase(std::unique(tileNeighbours.begin(), tileNeighbours.end()), tileNeighbours.end());
+    }
+}
+
+void SleepTiles::Wake(unsigned tile)
+{
+    calmSteps[tile] = 0;
+}
+
+void SleepTiles::WakeAll()
+{
+    std::fill(calmSteps.begin(), calmSteps.end(), 0);
+}
+
+void SleepTiles::WakeOnChange(const SimpleBox* box, const std::vector<ClothMaterial>& materials)
+{
+    const bool changed = !hasLastState || box->pos != lastBoxPos || box->scale != lastBoxScale ||
+        !(materials == lastMaterials);
+
+    if (!changed)
+        return;
+
+    WakeAll();
+
+    hasLastState = true;
+    lastBoxPos = box->pos;
+    lastBoxScale = box->scale;
+    lastMaterials = materials;
+}
+
+bool SleepTiles::EndStep(unsigned tile, float maxEnergy)
+{
+    if (!enabled)
+    {
+        calmSteps[tile] = 0;
+        return false;
+    }
+
+    if (maxEnergy >= energyThreshold)
+    {
+        calmSteps[tile] = 0;
+        disturbed[tile] = 1;
+        return false;
+    }
+
+    ++calmSteps[tile];
+    //only awake tiles are stepped, so reaching the limit here means it just fell asleep
+    return calmSteps[tile] >= stepsToSleep;
+}
+
+void SleepTiles::PropagateWakes()
+{
+    const unsigned tileCount = GetTileCount();
+
+    for (unsigned tile = 0; tile < tileCount; ++tile)
+    {
+        if (!disturbed[tile])
+            continue;
+
+        disturbed[tile] = 0;
+
+        for (unsigned neighbour : neighbours[tile])
+        {
+            if (calmSteps[neighbour] >= stepsToSleep)
+                calmSteps[neighbour] = 0;
+        }
+    }
+}
+
+unsigned SleepTiles::GetAwakeCount() const
+{
+    const unsigned tileCount = GetTileCount();
+
+    unsigned count = 0;
+    for (unsigned tile = 0; tile < tileCount; ++tile)
+    {
+        if (IsAwake(tile))
+            ++count;
+    }
+    return count;
+}
+
+void SleepTiles::GetAwakeTiles(std::vector<unsigned>& tiles) const
+{
+    tiles.clear();
+
+    const unsigned tileCount = GetTileCount();
+    for (unsigned tile = 0; tile < tileCount; ++tile)
+    {
+        if (IsAwake(tile))
+            tiles.push_back(tile);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Sleeping state of cloth tiles (groups of masses).
+ *                A tile whose masses all stay below energyThreshold for stepsToSleep steps
+ *                is not integrated any more, until it is woken by an anchor, the collider,
+ *                a material edit or a moving neighbour tile.
+ */
+#pragma once
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "ClothMaterial.h"
+
+class SimpleBox;
+
+//cloth state kept for a rollback : per mass, only entries of the saved tiles are meaningful
+struct ClothSnapshot
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> velocities;
+    std::vector<int> calmSteps;
+};
+
+class SleepTiles
+{
+public:
+    //all tiles awake, no neighbours
+    void Reset(unsigned tileCount);
+    //tiles sharing a spring / stencil, call FinishNeighbours after the last one
+    void AddNeighbours(unsigned tileA, unsigned tileB);
+    void FinishNeighbours();
+
+    bool IsAwake(unsigned tile) const
+    {
+        return !enabled || calmSteps[tile] < stepsToSleep;
+    }
+    void Wake(unsigned tile);
+    void WakeAll();
+    //wakes everything when the box moved or a material was edited since the last call
+    void WakeOnChange(const SimpleBox* box, const std::vector<ClothMaterial>& materials);
+
+    //after the tile was stepped, maxEnergy = largest kinetic energy of one of its masses.
+    //true when the tile just fell asleep, its velocities should be zeroed
+    bool EndStep(unsigned tile, float maxEnergy);
+    //tiles that moved this step wake their sleeping neighbours for the next one
+    void PropagateWakes();
+
+    unsigned GetTileCount() const { return static_cast<unsigned>(calmSteps.size()); }
+    unsigned GetAwakeCount() const;
+    void GetAwakeTiles(std::vector<unsigned>& tiles) const;
+    //for rollback, so a rolled back step doesn't change which tiles sleep
+    void GetCalmSteps(std::vector<int>& steps) const { steps = calmSteps; }
+    void SetCalmSteps(const std::vector<int>& steps) { calmSteps = steps; }
+
+    bool enabled = true;
+    float energyThreshold = 1e-7f;
+    int stepsToSleep = 60;
+
+private:
+    std::vector<int> calmSteps;
+    std::vector<unsigned char> disturbed;
+    std::vector<std::vector<unsigned>> neighbours;
+
+    bool hasLastState = false;
+    glm::vec3 lastBoxPos;
+    glm::vec3 lastBoxScale;
+    std::vector<ClothMaterial> lastMaterials;
+};
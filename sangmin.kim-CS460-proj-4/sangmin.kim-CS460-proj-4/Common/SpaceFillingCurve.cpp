@@ -0,0 +1,112 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Keys along Morton (Z-order) and Hilbert curves for 3D points.
+ */
+
+#include "SpaceFillingCurve.h"
+
+#include <algorithm>
+#include <glm/common.hpp>
+
+namespace
+{
+	const int bitsPerAxis = 10;
+
+	//abcdefghij -> a00b00c00d00e00f00g00h00i00j
+	uint32_t SpreadBits(uint32_t v)
+	{
+		v &= 0x3ff;
+		v = (v | (v << 16)) & 0x030000ff;
+		v = (v | (v << 8)) & 0x0300f00f;
+		v = (v | (v << 4)) & 0x030c30c3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
+	}
+}
+
+uint32_t SpaceFillingCurve::MortonKey(uint32_t x, uint32_t y, uint32_t z)
+{
+	return (SpreadBits(x) << 2) | (SpreadBits(y) << 1) | SpreadBits(z);
+}
+
+/*
+ * Skilling, "Programming the Hilbert curve" (2004) : axes to transposed Hilbert index,
+ * then the transposed bits are interleaved like a Morton key.
+ */
+uint32_t SpaceFillingCurve::HilbertKey(uint32_t x, uint32_t y, uint32_t z)
+{
+	uint32_t X[3] = { x & 0x3ff, y & 0x3ff, z & 0x3ff };
+	const uint32_t M = 1u << (bitsPerAxis - 1);
+
+	//inverse undo
+	for (uint32_t Q = M; Q > 1; Q >>= 1)
+	{
+		const uint32_t P = Q - 1;
+		for (int i = 0; i < 3; ++i)
+		{
+			if (X[i] & Q)
+				X[0] ^= P;
+			else
+			{
+				const uint32_t t = (X[0] ^ X[i]) & P;
+				X[0] ^= t;
+				X[i] ^= t;
+			}
+		}
+	}
+
+	//gray encode
+	for (int i = 1; i < 3; ++i)
+		X[i] ^= X[i - 1];
+
+	uint32_t t = 0;
+	for (uint32_t Q = M; Q > 1; Q >>= 1)
+	{
+		if (X[2] & Q)
+			t ^= Q - 1;
+	}
+	for (int i = 0; i < 3; ++i)
+		X[i] ^= t;
+
+	return MortonKey(X[0], X[1], X[2]);
+}
+
+std::vector<int> SpaceFillingCurve::SortOrder(const std::vector<glm::vec3>& points, Curve curve)
+{
+	const size_t count = points.size();
+
+	std::vector<int> order(count);
+	if (count == 0)
+		return order;
+
+	glm::vec3 minPoint = points[0];
+	glm::vec3 maxPoint = points[0];
+	for (const glm::vec3& point : points)
+	{
+		minPoint = glm::min(minPoint, point);
+		maxPoint = glm::max(maxPoint, point);
+	}
+
+	//one scale for all axes, keeps the curve cells cubic on flat cloth
+	const glm::vec3 extent = maxPoint - minPoint;
+	const float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+	const float scale = maxExtent > 0.f ? 1023.f / maxExtent : 0.f;
+
+	std::vector<uint32_t> keys(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const glm::vec3 cell = (points[i] - minPoint) * scale;
+		const uint32_t x = static_cast<uint32_t>(cell.x);
+		const uint32_t y = static_cast<uint32_t>(cell.y);
+		const uint32_t z = static_cast<uint32_t>(cell.z);
+
+		keys[i] = curve == HILBERT ? HilbertKey(x, y, z) : MortonKey(x, y, z);
+		order[i] = static_cast<int>(i);
+	}
+
+	//stable, points in the same cell keep insertion order
+	std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+	return order;
+}
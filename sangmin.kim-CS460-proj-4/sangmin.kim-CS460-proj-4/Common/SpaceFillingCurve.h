@@ -0,0 +1,28 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Keys along Morton (Z-order) and Hilbert curves for 3D points.
+ *                Sorting by key puts points that are close in space close in memory.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace SpaceFillingCurve
+{
+	enum Curve
+	{
+		MORTON,
+		HILBERT
+	};
+
+	//coordinates in [0, 1023]
+	uint32_t MortonKey(uint32_t x, uint32_t y, uint32_t z);
+	uint32_t HilbertKey(uint32_t x, uint32_t y, uint32_t z);
+
+	//order[i] = index of the point that goes to position i
+	std::vector<int> SortOrder(const std::vector<glm::vec3>& points, Curve curve);
+}
@@ -6,40 +6,45 @@
 
 #include "Spring.h"
 
-Spring::Spring(float springConstant, float restLength,
-               PointMass *mass1, PointMass *mass2, float dampingConstant)
+Spring::Spring(unsigned materialIndex, float restLengthScale_,
+               PointMass *mass1, PointMass *mass2)
 {
-    k = springConstant;
-    ogLength = restLength;
+    Reset(materialIndex, restLengthScale_, mass1, mass2);
+}
+
+void Spring::Reset(unsigned materialIndex, float restLengthScale_,
+               PointMass *mass1, PointMass *mass2)
+{
+    material = materialIndex;
+    restLengthScale = restLengthScale_;
     m1 = mass1;
     m2 = mass2;
-    kd = dampingConstant;
 }
 
-glm::vec3 Spring::GetSpringForce(PointMass* mass)
+glm::vec3 Spring::GetSpringForce(PointMass* mass, const ClothMaterial& mat)
 {
     const glm::vec3 dir = normalize(m2->position - m1->position);
-    const glm::vec3 springForce = HooksLaw() * dir;
+    const glm::vec3 springForce = HooksLaw(mat) * dir;
 
     if(mass == m1)
 		return springForce;
     return -springForce;
 }
 
-glm::vec3 Spring::GetDampingForce()
+glm::vec3 Spring::GetDampingForce(const ClothMaterial& mat)
 {
     const glm::vec3 dir = normalize(m2->position - m1->position);
 
-    const float dT = -kd * dot(dir, (m2->velocity + m1->velocity));
+    const float dT = -mat.dampingConstant * dot(dir, (m2->velocity + m1->velocity));
     const glm::vec3 dampingForce = dT * dir;
 
     return dampingForce;
 }
 
-float Spring::HooksLaw()
+float Spring::HooksLaw(const ClothMaterial& mat)
 {
     const float stretchedDistance = glm::distance(m1->position, m2->position);
-    const float hooksLaw = 0.5f * k * (stretchedDistance - ogLength);
+    const float hooksLaw = 0.5f * mat.springConstant * (stretchedDistance - mat.restLength * restLengthScale);
 
     return hooksLaw;
 }
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "glm/glm.hpp"
+#include "ClothMaterial.h"
 #include "Pointmass.h"
 
 class Buffer;
@@ -15,16 +16,19 @@ class Shader;
 class Spring
 {
 public:
-    Spring(float springConstant, float restLength,
-           PointMass *mass1, PointMass *mass2, float dampingConstant);
+    Spring(unsigned materialIndex, float restLengthScale_,
+           PointMass *mass1, PointMass *mass2);
+    void Reset(unsigned materialIndex, float restLengthScale_,
+           PointMass *mass1, PointMass *mass2);
     
-    glm::vec3 GetSpringForce(PointMass* mass);
-    glm::vec3 GetDampingForce();
-    float HooksLaw();
+    glm::vec3 GetSpringForce(PointMass* mass, const ClothMaterial& mat);
+    glm::vec3 GetDampingForce(const ClothMaterial& mat);
+    float HooksLaw(const ClothMaterial& mat);
     PointMass* m1;   
     PointMass* m2;
     int index;
-    float k;
-    float kd;
-    float ogLength;
+    //index to MassSpringSystem::materials
+    unsigned material;
+    //rest length = material rest length * restLengthScale (sqrt(2) for shear)
+    float restLengthScale;
 };
\ No newline at end of file
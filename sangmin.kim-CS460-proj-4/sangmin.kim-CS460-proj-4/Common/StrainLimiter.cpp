@@ -0,0 +1,153 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Strain limiting pass run after integration.
+ */
+
+#include "StrainLimiter.h"
+
+#include <atomic>
+#include <cmath>
+
+#include "JobSystem.h"
+
+namespace
+{
+    //smaller colours are cheaper on the calling thread than waking workers
+    const unsigned constraintsPerJob = 4096;
+
+    struct ProjectContext
+    {
+        float* px;
+        float* py;
+        float* pz;
+        float* vx;
+        float* vy;
+        float* vz;
+        const float* inverseMasses;
+        float maxStretch;
+        float invDt;
+    };
+
+    template <class Constraint>
+    bool ProjectRange(const ProjectContext& c, const Constraint* constraints, size_t begin, size_t end)
+    {
+        bool moved = false;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const int a = constraints[i].mass1;
+            const int b = constraints[i].mass2;
+
+            const float dX = c.px[b] - c.px[a];
+            const float dY = c.py[b] - c.py[a];
+            const float dZ = c.pz[b] - c.pz[a];
+            const float length = std::sqrt(dX * dX + dY * dY + dZ * dZ);
+            const float maxLength = constraints[i].referenceLength * (1.f + c.maxStretch);
+
+            if (length <= maxLength)
+                continue;
+
+            const float wA = c.inverseMasses[a];
+            const float wB = c.inverseMasses[b];
+            const float w = wA + wB;
+            if (w <= 0.f)
+                continue;
+
+            //both ends move along the spring, lighter one further
+            const float s = (length - maxLength) / (length * w);
+            const float cX = dX * s, cY = dY * s, cZ = dZ * s;
+
+            c.px[a] += wA * cX; c.py[a] += wA * cY; c.pz[a] += wA * cZ;
+            c.px[b] -= wB * cX; c.py[b] -= wB * cY; c.pz[b] -= wB * cZ;
+
+            c.vx[a] += wA * cX * c.invDt; c.vy[a] += wA * cY * c.invDt; c.vz[a] += wA * cZ * c.invDt;
+            c.vx[b] -= wB * cX * c.invDt; c.vy[b] -= wB * cY * c.invDt; c.vz[b] -= wB * cZ * c.invDt;
+
+            moved = true;
+        }
+
+        return moved;
+    }
+}
+
+void StrainLimiter::Reset(unsigned massCount)
+{
+    for (std::vector<Constraint>& colour : colours)
+        colour.clear();
+    uncoloured.clear();
+    usedColours.assign(massCount, 0);
+}
+
+void StrainLimiter::AddConstraint(int mass1, int mass2, float referenceLength, int colour)
+{
+    const Constraint constraint = { mass1, mass2, referenceLength };
+
+    if (colour < 0)
+    {
+        const uint64_t used = usedColours[mass1] | usedColours[mass2];
+
+        colour = 0;
+        while (colour < maxColours && (used & (uint64_t(1) << colour)))
+            ++colour;
+
+        if (colour == maxColours)
+        {
+            uncoloured.push_back(constraint);
+            return;
+        }
+    }
+
+    usedColours[mass1] |= uint64_t(1) << colour;
+    usedColours[mass2] |= uint64_t(1) << colour;
+
+    if (static_cast<int>(colours.size()) <= colour)
+        colours.resize(colour + 1);
+    colours[colour].push_back(constraint);
+}
+
+bool StrainLimiter::Project(float* px, float* py, float* pz, float* vx, float* vy, float* vz,
+    const float* inverseMasses, float maxStretch, int iterations, float dt, JobSystem* jobSystem)
+{
+    ProjectContext c;
+    c.px = px; c.py = py; c.pz = pz;
+    c.vx = vx; c.vy = vy; c.vz = vz;
+    c.inverseMasses = inverseMasses;
+    c.maxStretch = maxStretch;
+    c.invDt = dt > 0.f ? 1.f / dt : 0.f;
+
+    bool moved = false;
+
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (const std::vector<Constraint>& colour : colours)
+        {
+            const size_t count = colour.size();
+            const Constraint* constraints = colour.data();
+
+            if (jobSystem == nullptr || count <= constraintsPerJob)
+            {
+                moved |= ProjectRange(c, constraints, 0, count);
+                continue;
+            }
+
+            const unsigned jobCount = static_cast<unsigned>((count + constraintsPerJob - 1) / constraintsPerJob);
+            std::atomic<bool> anyMoved(false);
+
+            jobSystem->ParallelFor(jobCount, [&c, constraints, count, &anyMoved](unsigned job)
+            {
+                const size_t begin = job * constraintsPerJob;
+                const size_t end = begin + constraintsPerJob < count ? begin + constraintsPerJob : count;
+
+                if (ProjectRange(c, constraints, begin, end))
+                    anyMoved = true;
+            });
+
+            moved |= anyMoved.load();
+        }
+
+        moved |= ProjectRange(c, uncoloured.data(), 0, uncoloured.size());
+    }
+
+    return moved;
+}
@@ -0,0 +1,50 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Strain limiting pass run after integration.
+ *                Each constraint keeps two masses within (1 + maxStretch) of a reference length
+ *                by moving them apart / together (Provot style projection).
+ *                Constraints are coloured so no two of one colour share a mass,
+ *                a colour is then projected in parallel without locks.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+class StrainLimiter
+{
+public:
+    //no constraints, masses [0, massCount)
+    void Reset(unsigned massCount);
+    //colour < 0 : first colour neither mass uses yet (greedy), for any topology
+    void AddConstraint(int mass1, int mass2, float referenceLength, int colour = -1);
+
+    /*
+     * Positions and velocities as separate arrays, inverseMasses 0 for fixed masses.
+     * Moved masses also get the correction / dt on their velocity, so the next step
+     * doesn't stretch them again. Returns true when any mass was moved.
+     */
+    bool Project(float* px, float* py, float* pz, float* vx, float* vy, float* vz,
+        const float* inverseMasses, float maxStretch, int iterations, float dt, JobSystem* jobSystem);
+
+    unsigned GetColourCount() const { return static_cast<unsigned>(colours.size()); }
+
+private:
+    struct Constraint
+    {
+        int mass1;
+        int mass2;
+        float referenceLength;
+    };
+
+    static const int maxColours = 64;
+
+    std::vector<std::vector<Constraint>> colours;
+    //masses with more constraints than maxColours, projected on the calling thread
+    std::vector<Constraint> uncoloured;
+    //bit c set : mass has a constraint of colour c
+    std::vector<uint64_t> usedColours;
+};
@@ -17,10 +17,60 @@
 #define STBI_MSC_SECURE_CRT
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+#include "MappedFile.h"
+
 //#include "stb/stb_image_write.h"
 
+#define TEXTURE_CACHE_VERSION 1
+
+namespace
+{
+	const char textureCacheMagic[4] = { 'T', 'X', 'C', 'H' };
+	//a full chain for 2^31 texels, anything above is a corrupt file
+	const unsigned int maxCacheLevels = 32;
+	//width, height, byte size
+	const size_t cacheLevelHeaderSize = 2 * sizeof(int) + sizeof(unsigned int);
+
+	struct TextureCacheHeader
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned long long sourceHash;
+		unsigned int format;
+		unsigned int levelCount;
+	};
+
+	/*
+	 * stb flip flag is global (not per thread in this stb version),
+	 * so it is never set, and rows are flipped here instead.
+	 * Lets textures decode on worker threads while SkyBox loads unflipped images.
+	 */
+	unsigned char* LoadPixels(const std::string& path, int& w, int& h, int& channels, int desiredChannels, bool isFlip)
+	{
+		unsigned char* pixels = stbi_load(path.c_str(), &w, &h, &channels, desiredChannels);
+
+		if (pixels && isFlip)
+		{
+			const size_t rowSize = static_cast<size_t>(w) * (desiredChannels ? desiredChannels : channels);
+			std::vector<unsigned char> row(rowSize);
+
+			for (int y = 0; y < h / 2; ++y)
+			{
+				unsigned char* top = pixels + rowSize * y;
+				unsigned char* bottom = pixels + rowSize * (h - 1 - y);
+				std::memcpy(row.data(), top, rowSize);
+				std::memcpy(top, bottom, rowSize);
+				std::memcpy(bottom, row.data(), rowSize);
+			}
+		}
+		return pixels;
+	}
+}
+
 Texture::Texture(GLenum textureTarget, const std::string fileName)
 {
 	target = textureTarget;
@@ -39,16 +89,75 @@ void Texture::LoadEmptyTexture(int width, int height)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
+Texture::~Texture()
+{
+	stbi_image_free(imageData);
+
+	if (isUploaded)
+		glDeleteTextures(1, &textureObj);
+}
+
 bool Texture::Load()
 {
-	stbi_set_flip_vertically_on_load(1);
+	if (!Decode())
+		return false;
+
+	return Upload();
+}
+
+bool Texture::Decode()
+{
+	if (useCompression && ReadCompressedCache())
+		return true;
+
+	imageData = LoadPixels(file, imageWidth, imageHeight, imageBPP, 0, true);
+
+	if (imageData)
+		return true;
+
+	std::cout << "File does not exist" << file.c_str() << std::endl;
+	return false;
+}
+
+/*
+ * Upload with full mip chain. Compressed cache levels go straight to glCompressedTexImage2D,
+ * otherwise pixels are uploaded (as S3TC if compression is on) and mips generated.
+ */
+bool Texture::Upload()
+{
+	if (isUploaded)
+		return true;
 
-	unsigned char* imageData = stbi_load(file.c_str(), &imageWidth, &imageHeight, &imageBPP, 0);
+	if (!compressedLevels.empty())
+	{
+		glGenTextures(1, &textureObj);
+		glBindTexture(target, textureObj);
+
+		const int levelCount = static_cast<int>(compressedLevels.size());
+		for (int level = 0; level < levelCount; ++level)
+		{
+			const CompressedLevel& info = compressedLevels[level];
+			glCompressedTexImage2D(target, level, compressedFormat, info.width, info.height, 0,
+				static_cast<GLsizei>(info.size), compressedData.data() + info.offset);
+		}
+		SetSamplerParameters(levelCount);
+
+		glBindTexture(target, 0);
+
+		std::vector<unsigned char>().swap(compressedData);
+		std::vector<CompressedLevel>().swap(compressedLevels);
+
+		isUploaded = true;
+		return true;
+	}
 
 	if(imageData)
 	{
 		glGenTextures(1, &textureObj);
 		glBindTexture(target, textureObj);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		const bool compress = useCompression && (imageBPP == 3 || imageBPP == 4);
 
 		switch(imageBPP)
 		{
@@ -56,30 +165,180 @@ bool Texture::Load()
 			glTexImage2D(target, 0, GL_RED, imageWidth, imageHeight, 0, GL_RED, GL_UNSIGNED_BYTE, imageData);
 			break;
 		case 3:
-			glTexImage2D(target, 0, GL_RGB, imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
+			glTexImage2D(target, 0, compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB,
+				imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
 			break;
 		case 4:
-			glTexImage2D(target, 0, GL_RGBA, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
+			glTexImage2D(target, 0, compress ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_RGBA,
+				imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
 			break;
 		default:
 			break;
 		}
 
-		glTexParameterf(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameterf(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameterf(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameterf(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glGenerateMipmap(target);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		int levelCount = 1;
+		for (int size = std::max(imageWidth, imageHeight); size > 1; size /= 2)
+			++levelCount;
+		SetSamplerParameters(levelCount);
+
+		if (compress)
+			WriteCompressedCache();
 
 		glBindTexture(target, 0);
 
 		stbi_image_free(imageData);
+		imageData = nullptr;
 
+		isUploaded = true;
 		return true;
 	}
-	std::cout << "File does not exist" << file.c_str() << std::endl;
 	return false;
 }
 
+void Texture::SetCompression(bool compress)
+{
+	useCompression = compress;
+}
+
+void Texture::SetSamplerParameters(int levelCount)
+{
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	glTexParameterf(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameterf(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameterf(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	if (GLEW_EXT_texture_filter_anisotropic)
+	{
+		GLfloat maxAnisotropy = 1.f;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(maxAnisotropy, 8.f));
+	}
+}
+
+/*
+ * <file>.texcache : magic, version, source hash, format, level count,
+ * then per level width, height, byte size, data.
+ */
+bool Texture::ReadCompressedCache()
+{
+	MappedFile source(file);
+	if (!source.IsOpen())
+		return false;
+	sourceHash = source.Hash();
+
+	MappedFile cache(file + ".texcache");
+	if (!cache.IsOpen())
+		return false;
+
+	const char* cursor = cache.GetData();
+	const char* end = cursor + cache.GetSize();
+
+	auto read = [&cursor, end](void* out, size_t size)
+	{
+		if (static_cast<size_t>(end - cursor) < size)
+			return false;
+		std::memcpy(out, cursor, size);
+		cursor += size;
+		return true;
+	};
+
+	TextureCacheHeader header;
+	if (!read(&header, sizeof(header)) || std::memcmp(header.magic, textureCacheMagic, 4) != 0
+		|| header.version != TEXTURE_CACHE_VERSION || header.sourceHash != sourceHash)
+		return false;
+
+	//count comes from the file, check it against what is left before allocating
+	if (header.levelCount == 0 || header.levelCount > maxCacheLevels
+		|| header.levelCount > static_cast<size_t>(end - cursor) / cacheLevelHeaderSize)
+		return false;
+
+	std::vector<CompressedLevel> levels(header.levelCount);
+	size_t totalSize = 0;
+	const char* dataStart = nullptr;
+
+	for (CompressedLevel& level : levels)
+	{
+		unsigned int size = 0;
+		if (!read(&level.width, sizeof(int)) || !read(&level.height, sizeof(int)) || !read(&size, sizeof(size)))
+			return false;
+		if (static_cast<size_t>(end - cursor) < size)
+			return false;
+
+		if (!dataStart)
+			dataStart = cursor;
+		level.offset = static_cast<size_t>(cursor - dataStart);
+		level.size = size;
+		cursor += size;
+		totalSize = level.offset + level.size;
+	}
+
+	compressedData.assign(dataStart, dataStart + totalSize);
+	compressedLevels.swap(levels);
+	compressedFormat = header.format;
+	imageWidth = compressedLevels[0].width;
+	imageHeight = compressedLevels[0].height;
+
+	return true;
+}
+
+void Texture::WriteCompressedCache()
+{
+	GLint isCompressed = GL_FALSE;
+	glGetTexLevelParameteriv(target, 0, GL_TEXTURE_COMPRESSED, &isCompressed);
+	if (isCompressed != GL_TRUE)
+		return;
+
+	if (sourceHash == 0)
+	{
+		MappedFile source(file);
+		sourceHash = source.Hash();
+	}
+
+	TextureCacheHeader header;
+	std::memcpy(header.magic, textureCacheMagic, 4);
+	header.version = TEXTURE_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+
+	GLint format = 0;
+	glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+	header.format = static_cast<unsigned int>(format);
+
+	int levelCount = 1;
+	for (int size = std::max(imageWidth, imageHeight); size > 1; size /= 2)
+		++levelCount;
+	header.levelCount = static_cast<unsigned int>(levelCount);
+
+	std::ofstream stream(file + ".texcache", std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return;
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<unsigned char> levelData;
+	for (int level = 0; level < levelCount; ++level)
+	{
+		GLint width = 0, height = 0, size = 0;
+		glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+
+		levelData.resize(static_cast<size_t>(size));
+		glGetCompressedTexImage(target, level, levelData.data());
+
+		const unsigned int byteSize = static_cast<unsigned int>(size);
+		stream.write(reinterpret_cast<const char*>(&width), sizeof(int));
+		stream.write(reinterpret_cast<const char*>(&height), sizeof(int));
+		stream.write(reinterpret_cast<const char*>(&byteSize), sizeof(byteSize));
+		stream.write(reinterpret_cast<const char*>(levelData.data()), size);
+	}
+
+	std::cout << "Write compressed texture cache : " << file << ".texcache" << std::endl;
+}
+
 void Texture::Bind(GLenum textureUnit)
 {
 	glActiveTexture(textureUnit);
@@ -108,6 +367,11 @@ GLuint Texture::GetTextureObj()
 	return textureObj;
 }
 
+const std::string& Texture::GetFilePath() const
+{
+	return file;
+}
+
 
 unsigned char* Image::Load_Image(std::string path, int& w, int& h, bool isFlip)
 {
@@ -115,9 +379,7 @@ unsigned char* Image::Load_Image(std::string path, int& w, int& h, bool isFlip)
 	{
 		color_datas.clear();
 	}
-	stbi_set_flip_vertically_on_load(isFlip);
-
-	unsigned char* data = stbi_load(path.c_str(), &image_w, &image_h, &image_channel, color_channel);
+	unsigned char* data = LoadPixels(path, image_w, image_h, image_channel, color_channel, isFlip);
 	if (data)
 	{
 		pixel_size = image_w * image_h * color_channel;
@@ -20,15 +20,41 @@ class Texture
 {
 public:
 	Texture(GLenum textureTarget, const std::string fileName);
+	~Texture();
 	void LoadEmptyTexture(int width, int height);
 	bool Load();
+	//Decode : read / decode image file (or compressed cache), safe on worker thread.
+	//Upload : create mipmapped GL texture from decoded pixels, GL thread only. Uploads once.
+	bool Decode();
+	bool Upload();
+	//Store as S3TC, driver compressed levels are written to <file>.texcache on first upload.
+	void SetCompression(bool compress);
 	void Bind(GLenum textureUnit);
 	void SaveImg();
 	GLuint GetTextureObj();
+	const std::string& GetFilePath() const;
 private:
+	struct CompressedLevel
+	{
+		int width, height;
+		size_t offset, size;
+	};
+
+	bool ReadCompressedCache();
+	void WriteCompressedCache();
+	void SetSamplerParameters(int levelCount);
+
 	int imageWidth, imageHeight, imageBPP;
 	GLenum target;
 	std::string file;
+	unsigned char* imageData = nullptr;
+	unsigned long long sourceHash = 0;
+
+	bool useCompression = false;
+	bool isUploaded = false;
+	GLenum compressedFormat = 0;
+	std::vector<unsigned char> compressedData;
+	std::vector<CompressedLevel> compressedLevels;
 
 	GLuint textureObj;
 };
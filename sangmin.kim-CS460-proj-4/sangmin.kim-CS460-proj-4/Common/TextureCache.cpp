@@ -0,0 +1,66 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Shared textures keyed by file path.
+ */
+
+#include "TextureCache.h"
+
+#include "Texture.h"
+
+TextureCache& TextureCache::Get()
+{
+	static TextureCache instance;
+	return instance;
+}
+
+/*
+ * Map lock is only held for lookup, decoding runs under entry's once_flag,
+ * so different files decode in parallel and same file waits for first decode.
+ */
+Texture* TextureCache::Acquire(const std::string& path)
+{
+	Entry* entry = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::unique_ptr<Entry>& slot = entries[path];
+		if (!slot)
+		{
+			slot.reset(new Entry());
+			slot->texture = new Texture(GL_TEXTURE_2D, path);
+			slot->texture->SetCompression(useCompression);
+		}
+		entry = slot.get();
+	}
+
+	std::call_once(entry->decodeOnce, [entry]()
+		{
+			entry->decoded = entry->texture->Decode();
+		});
+
+	return entry->decoded ? entry->texture : nullptr;
+}
+
+void TextureCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto& pair : entries)
+		delete pair.second->texture;
+
+	entries.clear();
+}
+
+size_t TextureCache::GetCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+void TextureCache::SetCompression(bool compress)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	useCompression = compress;
+}
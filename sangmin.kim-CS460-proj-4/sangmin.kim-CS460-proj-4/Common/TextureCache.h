@@ -0,0 +1,45 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Shared textures keyed by file path.
+ *                Each file is decoded once even if several materials / threads ask for it at the same time,
+ *                and uploaded once (Texture::Upload is idempotent).
+ *                Textures are owned here, Clear on GL thread before context goes away.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class Texture;
+
+class TextureCache
+{
+public:
+	static TextureCache& Get();
+
+	//Any thread. Returns decoded texture, nullptr if file failed to decode.
+	Texture* Acquire(const std::string& path);
+	void Clear();
+	size_t GetCount();
+
+	//Applies to textures acquired afterwards.
+	void SetCompression(bool compress);
+
+private:
+	TextureCache() = default;
+
+	struct Entry
+	{
+		Texture* texture = nullptr;
+		bool decoded = false;
+		std::once_flag decodeOnce;
+	};
+
+	std::mutex mutex;
+	std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+	bool useCompression = false;
+};
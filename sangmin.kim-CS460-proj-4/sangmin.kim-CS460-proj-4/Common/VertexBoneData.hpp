@@ -11,6 +11,10 @@
 #include <glm/fwd.hpp>
 
 #define MAX_NUM_BONES_PER_VERTEX 16
+
+// Influences kept per vertex after import (BoneStorageManager), packed in groups of 4.
+#define DEFAULT_NUM_BONES_PER_VERTEX 4
+#define MAX_PACKED_BONES_PER_VERTEX 8
 using uint = glm::uint;
 
 struct VertexBoneData
@@ -0,0 +1,204 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Reorder triangle list for post-transform vertex cache.
+ */
+
+#include "VertexCacheOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const int modelledCacheSize = 32;
+	const float cacheDecayPower = 1.5f;
+	const float lastTriangleScore = 0.75f;
+	const float valenceBoostScale = 2.f;
+	const float valenceBoostPower = 0.5f;
+
+	float VertexScore(int cachePosition, unsigned remainingValence)
+	{
+		if (remainingValence == 0)
+			return -1.f;
+
+		float score = 0.f;
+
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = lastTriangleScore;
+			else
+			{
+				const float scaler = 1.f / (modelledCacheSize - 3);
+				score = std::pow(1.f - (cachePosition - 3) * scaler, cacheDecayPower);
+			}
+		}
+
+		score += valenceBoostScale * std::pow(static_cast<float>(remainingValence), -valenceBoostPower);
+		return score;
+	}
+}
+
+namespace VertexCacheOptimizer
+{
+	void Optimize(unsigned* indices, size_t indexCount, unsigned vertexCount)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2 || vertexCount == 0)
+			return;
+
+		//vertex -> triangles adjacency (offsets + flat list)
+		std::vector<unsigned> valence(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++valence[indices[i]];
+
+		std::vector<unsigned> adjacencyOffsets(vertexCount + 1, 0);
+		for (unsigned v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+
+		std::vector<unsigned> adjacency(triangleCount * 3);
+		{
+			std::vector<unsigned> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const unsigned v = indices[t * 3 + corner];
+					adjacency[fill[v]++] = static_cast<unsigned>(t);
+				}
+			}
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (unsigned v = 0; v < vertexCount; ++v)
+			vertexScores[v] = VertexScore(-1, valence[v]);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]]
+				+ vertexScores[indices[t * 3 + 2]];
+		}
+
+		std::vector<unsigned> output;
+		output.reserve(triangleCount * 3);
+
+		std::vector<unsigned> cache;
+		std::vector<unsigned> nextCache;
+		cache.reserve(modelledCacheSize + 3);
+		nextCache.reserve(modelledCacheSize + 3);
+
+		size_t scanStart = 0;
+		int bestTriangle = -1;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+		{
+			//no candidate from cache : next best by linear scan over remaining
+			if (bestTriangle < 0)
+			{
+				float bestScore = -1.f;
+				for (size_t t = scanStart; t < triangleCount; ++t)
+				{
+					if (emitted[t])
+					{
+						if (t == scanStart)
+							++scanStart;
+						continue;
+					}
+					if (triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = static_cast<int>(t);
+					}
+				}
+			}
+
+			const unsigned* corners = indices + bestTriangle * 3;
+			output.insert(output.end(), corners, corners + 3);
+			emitted[bestTriangle] = true;
+
+			//emitted triangle vertices move to front of LRU cache
+			nextCache.clear();
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				const unsigned v = corners[corner];
+				nextCache.push_back(v);
+
+				//remove triangle from vertex adjacency
+				unsigned* begin = adjacency.data() + adjacencyOffsets[v];
+				unsigned* end = begin + valence[v];
+				std::swap(*std::find(begin, end, static_cast<unsigned>(bestTriangle)), *(end - 1));
+				--valence[v];
+			}
+			for (unsigned v : cache)
+			{
+				if (v != corners[0] && v != corners[1] && v != corners[2])
+					nextCache.push_back(v);
+			}
+			for (size_t i = modelledCacheSize; i < nextCache.size(); ++i)
+			{
+				cachePositions[nextCache[i]] = -1;
+				vertexScores[nextCache[i]] = VertexScore(-1, valence[nextCache[i]]);
+			}
+			if (nextCache.size() > static_cast<size_t>(modelledCacheSize))
+				nextCache.resize(modelledCacheSize);
+			cache.swap(nextCache);
+
+			//rescore vertices in cache, then their triangles
+			for (size_t i = 0; i < cache.size(); ++i)
+			{
+				cachePositions[cache[i]] = static_cast<int>(i);
+				vertexScores[cache[i]] = VertexScore(static_cast<int>(i), valence[cache[i]]);
+			}
+
+			bestTriangle = -1;
+			float bestScore = -1.f;
+			for (unsigned v : cache)
+			{
+				const unsigned* begin = adjacency.data() + adjacencyOffsets[v];
+				for (unsigned a = 0; a < valence[v]; ++a)
+				{
+					const unsigned t = begin[a];
+					const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]]
+						+ vertexScores[indices[t * 3 + 2]];
+					triangleScores[t] = score;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = static_cast<int>(t);
+					}
+				}
+			}
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	float CalculateACMR(const unsigned* indices, size_t indexCount, unsigned vertexCount, unsigned cacheSize)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return 0.f;
+
+		//FIFO cache : vertex is in cache if it was loaded within last cacheSize misses
+		std::vector<size_t> loadedAt(vertexCount, 0);
+		size_t misses = 0;
+
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			const unsigned v = indices[i];
+			if (loadedAt[v] == 0 || misses + 1 - loadedAt[v] > cacheSize)
+			{
+				++misses;
+				loadedAt[v] = misses;
+			}
+		}
+
+		return static_cast<float>(misses) / static_cast<float>(triangleCount);
+	}
+}
@@ -0,0 +1,17 @@
+/*
+ * Author		: Ryan Kim.
+ * Date			: 2022-10-07
+ * Description	: Reorder triangle list for post-transform vertex cache (Forsyth, linear speed).
+ *                ACMR : average cache misses per triangle with simulated FIFO cache.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace VertexCacheOptimizer
+{
+	//indices are relative to one mesh : [0, vertexCount)
+	void Optimize(unsigned* indices, size_t indexCount, unsigned vertexCount);
+	float CalculateACMR(const unsigned* indices, size_t indexCount, unsigned vertexCount, unsigned cacheSize = 16);
+}
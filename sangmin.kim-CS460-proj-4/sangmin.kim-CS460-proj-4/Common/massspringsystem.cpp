@@ -6,6 +6,7 @@
 
 #include "massspringsystem.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "Buffer.hpp"
@@ -20,27 +21,68 @@ MassSpringSystem::MassSpringSystem(Shader* dotShader_, Shader* lineShader_)
 
 MassSpringSystem::~MassSpringSystem()
 {
-    for (unsigned i=0; i<masses.size(); i++) {
-        delete masses[i];
+    Reset();
+
+    for (unsigned i=0; i<spareMasses.size(); i++) {
+        delete spareMasses[i];
     }
-    for (unsigned i=0; i<springs.size(); i++) {
-        delete springs[i];
+    for (unsigned i=0; i<spareSprings.size(); i++) {
+        delete spareSprings[i];
     }
+
+    delete dotPosBuffer;
+    delete springPosBuffer;
+    glDeleteVertexArrays(1, &dotShaderVao);
+    glDeleteVertexArrays(1, &springShaderVao);
+}
+
+void MassSpringSystem::Reset()
+{
+    //reversed so pop_back hands them out in the previous order
+    spareMasses.insert(spareMasses.end(), masses.rbegin(), masses.rend());
+    spareSprings.insert(spareSprings.end(), springs.rbegin(), springs.rend());
+
+    masses.clear();
+    springs.clear();
+    massesPositions.clear();
+    springPositions.clear();
 }
 
-PointMass* MassSpringSystem::AddMass(float mass, float x, float y, float z)
+unsigned MassSpringSystem::AddMaterial(const ClothMaterial& material)
 {
-    PointMass *m = new PointMass(mass, x, y, z);
+    materials.push_back(material);
+    return static_cast<unsigned>(materials.size() - 1);
+}
+
+PointMass* MassSpringSystem::AddMass(unsigned material, float x, float y, float z)
+{
+    PointMass *m;
+    if (spareMasses.empty())
+        m = new PointMass(material, x, y, z);
+    else
+    {
+        m = spareMasses.back();
+        spareMasses.pop_back();
+        m->Reset(material, x, y, z);
+    }
     masses.push_back(m);
     return m;
 }
 
-void MassSpringSystem::AddSpring(float springConstant, float restLength,
-    int mass1Index, int mass2Index, float dampingConstant)
+void MassSpringSystem::AddSpring(unsigned material, float restLengthScale,
+    int mass1Index, int mass2Index)
 {
     PointMass* mass1 = masses[mass1Index];
     PointMass* mass2 = masses[mass2Index];
-    Spring *s = new Spring(springConstant, restLength, mass1, mass2, dampingConstant);
+    Spring *s;
+    if (spareSprings.empty())
+        s = new Spring(material, restLengthScale, mass1, mass2);
+    else
+    {
+        s = spareSprings.back();
+        spareSprings.pop_back();
+        s->Reset(material, restLengthScale, mass1, mass2);
+    }
     mass1->springs.push_back(s);
     mass2->springs.push_back(s);
     springs.push_back(s);
@@ -49,29 +91,226 @@ void MassSpringSystem::AddSpring(float springConstant, float restLength,
 
 void MassSpringSystem::update(float dt, SimpleBox* box)
 {
-    // update mass objects
+    if (dt <= 0.f)
+        return;
+
+    sleepTiles.WakeOnChange(box, materials);
+
+    const unsigned massesSize = masses.size();
+    const unsigned tileCount = sleepTiles.GetTileCount();
+    const float invDt = 1.f / dt;
+
+    for (unsigned tile = 0; tile < tileCount; tile++)
+    {
+        if (!sleepTiles.IsAwake(tile))
+            continue;
+
+        const unsigned first = tile * massesPerTile;
+        const unsigned last = std::min(first + massesPerTile, massesSize);
+
+        // update mass objects, energy from how far they really moved (colliding masses keep their velocity)
+        float maxEnergy = 0.f;
+        for (unsigned i = first; i < last; i++)
+        {
+            const glm::vec3 before = masses[i]->position;
+            masses[i]->update(dt, massesPositions, box, materials.data());
+
+            const glm::vec3 velocity = (masses[i]->position - before) * invDt;
+            const float energy = 0.5f * materials[masses[i]->material].mass * glm::dot(velocity, velocity);
+            maxEnergy = std::max(maxEnergy, energy);
+        }
+
+        if (sleepTiles.EndStep(tile, maxEnergy))
+        {
+            for (unsigned i = first; i < last; i++)
+                masses[i]->velocity = glm::vec3(0.f);
+        }
+
+        const std::vector<unsigned>& currTileSprings = tileSprings[tile];
+        for (unsigned springIndex : currTileSprings)
+        {
+            int indexInVector = springIndex * 2;
+            Spring* currSpring = springs[springIndex];
+            springPositions[indexInVector] = currSpring->m1->position;
+            springPositions[indexInVector + 1] = currSpring->m2->position;
+        }
+
+        positionsDirty = true;
+    }
+
+    sleepTiles.PropagateWakes();
+}
+
+bool MassSpringSystem::SetMassPosition(int index, glm::vec3 position)
+{
+    if (masses[index]->position == position)
+        return false;
+
+    masses[index]->position = position;
+    massesPositions[index] = position;
+    sleepTiles.Wake(index / massesPerTile);
+    positionsDirty = true;
+    return true;
+}
+
+void MassSpringSystem::LimitStrain(float dt, float maxStretch, int iterations, JobSystem* jobSystem)
+{
+    const unsigned massesSize = masses.size();
+
+    std::vector<float>* arrays[] = { &limitPx, &limitPy, &limitPz, &limitVx, &limitVy, &limitVz, &inverseMasses };
+    for (std::vector<float>* a : arrays)
+        a->resize(massesSize);
+
+    for (unsigned i = 0; i < massesSize; i++)
+    {
+        const PointMass* mass = masses[i];
+        limitPx[i] = mass->position.x; limitPy[i] = mass->position.y; limitPz[i] = mass->position.z;
+        limitVx[i] = mass->velocity.x; limitVy[i] = mass->velocity.y; limitVz[i] = mass->velocity.z;
+        inverseMasses[i] = mass->isFixedPosition ? 0.f : 1.f / materials[mass->material].mass;
+    }
+
+    if (!strainLimiter.Project(limitPx.data(), limitPy.data(), limitPz.data(),
+        limitVx.data(), limitVy.data(), limitVz.data(), inverseMasses.data(), maxStretch, iterations, dt, jobSystem))
+        return;
+
+    for (unsigned i = 0; i < massesSize; i++)
+    {
+        const glm::vec3 position(limitPx[i], limitPy[i], limitPz[i]);
+        if (position == masses[i]->position)
+            continue;
+
+        // sleeping masses pulled by a neighbour tile wake up
+        masses[i]->position = position;
+        masses[i]->velocity = glm::vec3(limitVx[i], limitVy[i], limitVz[i]);
+        massesPositions[i] = position;
+        sleepTiles.Wake(i / massesPerTile);
+    }
+
+    const unsigned springSize = springs.size();
+    for (unsigned i = 0; i < springSize; i++)
+    {
+        springPositions[i * 2] = springs[i]->m1->position;
+        springPositions[i * 2 + 1] = springs[i]->m2->position;
+    }
+
+    positionsDirty = true;
+}
+
+void MassSpringSystem::SaveState(const std::vector<unsigned>& tiles, ClothSnapshot& snapshot) const
+{
     const unsigned massesSize = masses.size();
-    for (unsigned i=0; i< massesSize; i++) 
+
+    snapshot.positions.resize(massesSize);
+    snapshot.velocities.resize(massesSize);
+    sleepTiles.GetCalmSteps(snapshot.calmSteps);
+
+    for (unsigned tile : tiles)
     {
-        masses[i]->update(dt, massesPositions, box);
+        const unsigned first = tile * massesPerTile;
+        const unsigned last = std::min(first + massesPerTile, massesSize);
+
+        for (unsigned i = first; i < last; i++)
+        {
+            snapshot.positions[i] = masses[i]->position;
+            snapshot.velocities[i] = masses[i]->velocity;
+        }
     }
+}
+
+void MassSpringSystem::RestoreState(const std::vector<unsigned>& tiles, const ClothSnapshot& snapshot,
+    bool keepVelocities)
+{
+    const unsigned massesSize = masses.size();
 
+    for (unsigned tile : tiles)
+    {
+        const unsigned first = tile * massesPerTile;
+        const unsigned last = std::min(first + massesPerTile, massesSize);
+
+        for (unsigned i = first; i < last; i++)
+        {
+            masses[i]->position = snapshot.positions[i];
+            masses[i]->velocity = keepVelocities ? snapshot.velocities[i] : glm::vec3(0.f);
+            massesPositions[i] = snapshot.positions[i];
+        }
+
+        for (unsigned springIndex : tileSprings[tile])
+        {
+            springPositions[springIndex * 2] = springs[springIndex]->m1->position;
+            springPositions[springIndex * 2 + 1] = springs[springIndex]->m2->position;
+        }
+    }
+
+    sleepTiles.SetCalmSteps(snapshot.calmSteps);
+    positionsDirty = true;
+}
+
+void MassSpringSystem::GetSpringLengths(std::vector<float>& lengths, std::vector<float>& restLengths) const
+{
     const unsigned springSize = springs.size();
+
+    lengths.resize(springSize);
+    restLengths.resize(springSize);
+
     for (unsigned i = 0; i < springSize; i++)
     {
-        int index = springs[i]->index;
-        int indexInVector = index * 2;
-        Spring* currSpring = springs[i];
-        springPositions[indexInVector] = currSpring->m1->position;
-        springPositions[indexInVector + 1] = currSpring->m2->position;
+        const Spring* spring = springs[i];
+        lengths[i] = glm::distance(spring->m1->position, spring->m2->position);
+        restLengths[i] = materials[spring->material].restLength * spring->restLengthScale;
+    }
+}
+
+void MassSpringSystem::GetTileSprings(const std::vector<unsigned>& tiles, std::vector<unsigned>& springIndices) const
+{
+    springIndices.clear();
+
+    for (unsigned tile : tiles)
+        springIndices.insert(springIndices.end(), tileSprings[tile].begin(), tileSprings[tile].end());
+}
+
+void MassSpringSystem::GetSpringLengths(const std::vector<unsigned>& springIndices, std::vector<float>& lengths) const
+{
+    for (unsigned springIndex : springIndices)
+    {
+        const Spring* spring = springs[springIndex];
+        lengths[springIndex] = glm::distance(spring->m1->position, spring->m2->position);
+    }
+}
+
+void MassSpringSystem::GetStiffnessRatios(float& stiffnessToMass, float& dampingToMass) const
+{
+    stiffnessToMass = 0.f;
+    dampingToMass = 0.f;
+
+    const unsigned massesSize = masses.size();
+    for (unsigned i = 0; i < massesSize; i++)
+    {
+        float stiffness = 0.f;
+        float damping = 0.f;
+
+        const std::vector<Spring*>& massSprings = masses[i]->springs;
+        for (const Spring* spring : massSprings)
+        {
+            stiffness += 0.5f * materials[spring->material].springConstant;
+            damping += materials[spring->material].dampingConstant;
+        }
+
+        const float mass = materials[masses[i]->material].mass;
+        stiffnessToMass = std::max(stiffnessToMass, stiffness / mass);
+        dampingToMass = std::max(dampingToMass, damping / mass);
     }
 }
 
 void MassSpringSystem::draw(glm::mat4 projViewMat)
 {
+    //nothing moved : buffers already hold these positions
+    const bool upload = positionsDirty;
+    positionsDirty = false;
+
     dotShader->Use();
     glBindVertexArray(dotShaderVao);
-    dotPosBuffer->WriteData(massesPositions);
+    if (upload)
+        dotPosBuffer->WriteRange(massesPositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * massesPositions.size()));
     dotPosBuffer->Bind();
     dotShader->SendUniformMatGLM("projViewModelMat", projViewMat);
     glDrawArrays(GL_POINTS, 0, massesPositions.size());
@@ -79,35 +318,63 @@ void MassSpringSystem::draw(glm::mat4 projViewMat)
 
     lineShader->Use();
     glBindVertexArray(springShaderVao);
-    springPosBuffer->WriteData(springPositions);
+    if (upload)
+        springPosBuffer->WriteRange(springPositions.data(), static_cast<unsigned>(sizeof(glm::vec3) * springPositions.size()));
     springPosBuffer->Bind();
     lineShader->SendUniformMatGLM("gWVP", projViewMat);
     glDrawArrays(GL_LINES, 0, springPositions.size());
     glBindVertexArray(0);
 }
 
-void MassSpringSystem::Initializing()
+/*
+ * Same or smaller size than before only rewrites the buffer,
+ * VAO is created once and a new buffer is made only when it has to grow.
+ */
+static void UploadPositions(unsigned& vao, Buffer*& buffer, const std::vector<glm::vec3>& positions)
 {
-    const unsigned massesSize = masses.size();
+    const unsigned bytes = static_cast<unsigned>(sizeof(glm::vec3) * positions.size());
 
-    for (unsigned i = 0; i < massesSize; i++) {
-        massesPositions.push_back(masses[i]->position);
-        masses[i]->index = i;
+    if (vao == 0)
+        glGenVertexArrays(1, &vao);
+
+    if (buffer != nullptr && static_cast<unsigned>(buffer->GetSize()) >= bytes)
+    {
+        buffer->WriteRange(positions.data(), bytes);
+        return;
     }
 
-    glGenVertexArrays(1, &dotShaderVao);
-    glBindVertexArray(dotShaderVao);
+    delete buffer;
 
-    dotPosBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * massesPositions.size(), GL_STATIC_DRAW,
-        massesPositions.data());
-    dotPosBuffer->Bind();
+    glBindVertexArray(vao);
+
+    buffer = new Buffer(GL_ARRAY_BUFFER, bytes, GL_DYNAMIC_DRAW, positions.data());
+    buffer->Bind();
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<GLvoid*>(0));
 
     glBindVertexArray(0);
+}
+
+void MassSpringSystem::Initializing()
+{
+    const unsigned massesSize = masses.size();
+
+    massesPositions.clear();
+    massesPositions.reserve(massesSize);
+
+    for (unsigned i = 0; i < massesSize; i++) {
+        massesPositions.push_back(masses[i]->position);
+        masses[i]->index = i;
+    }
+
+    UploadPositions(dotShaderVao, dotPosBuffer, massesPositions);
 
     // draw springs
     const unsigned springsSize = springs.size();
+
+    springPositions.clear();
+    springPositions.reserve(springsSize * 2);
+
     for (unsigned i = 0; i < springsSize; i++) 
     {
         springPositions.push_back(springs[i]->m1->position);
@@ -115,15 +382,112 @@ void MassSpringSystem::Initializing()
         springs[i]->index = i;
     }
 
-    glGenVertexArrays(1, &springShaderVao);
-    glBindVertexArray(springShaderVao);
+    UploadPositions(springShaderVao, springPosBuffer, springPositions);
+    positionsDirty = false;
 
-    springPosBuffer = new Buffer(GL_ARRAY_BUFFER, sizeof(glm::vec3) * springPositions.size(), GL_STATIC_DRAW,
-        springPositions.data());
-    springPosBuffer->Bind();
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<GLvoid*>(0));
+    // sleeping tiles, neighbours through springs that cross tiles
+    const unsigned tileCount = (massesSize + massesPerTile - 1) / massesPerTile;
 
-    glBindVertexArray(0);
+    sleepTiles.Reset(tileCount);
+
+    tileSprings.resize(tileCount);
+    for (unsigned tile = 0; tile < tileCount; tile++)
+        tileSprings[tile].clear();
+
+    for (unsigned i = 0; i < springsSize; i++)
+    {
+        const unsigned tile1 = springs[i]->m1->index / massesPerTile;
+        const unsigned tile2 = springs[i]->m2->index / massesPerTile;
+
+        tileSprings[tile1].push_back(i);
+        if (tile2 != tile1)
+        {
+            tileSprings[tile2].push_back(i);
+            sleepTiles.AddNeighbours(tile1, tile2);
+        }
+    }
+
+    sleepTiles.FinishNeighbours();
+
+    // strain limit constraints, reference lengths are the springs as built
+    strainLimiter.Reset(massesSize);
+    for (unsigned i = 0; i < springsSize; i++)
+    {
+        const Spring* spring = springs[i];
+        strainLimiter.AddConstraint(spring->m1->index, spring->m2->index,
+            glm::distance(spring->m1->position, spring->m2->position));
+    }
+}
+
+std::vector<int> MassSpringSystem::ReorderMasses(SpaceFillingCurve::Curve curve)
+{
+    const unsigned massesSize = masses.size();
+    const unsigned springsSize = springs.size();
+
+    std::vector<glm::vec3> positions(massesSize);
+    for (unsigned i = 0; i < massesSize; i++) {
+        positions[i] = masses[i]->position;
+        masses[i]->index = i;
+    }
 
-}
\ No newline at end of file
+    const std::vector<int> order = SpaceFillingCurve::SortOrder(positions, curve);
+
+    std::vector<int> newIndex(massesSize);
+    for (unsigned i = 0; i < massesSize; i++)
+        newIndex[order[i]] = i;
+
+    struct SpringContent
+    {
+        unsigned material;
+        float restLengthScale;
+        int mass1Index;
+        int mass2Index;
+    };
+
+    //lower endpoint first, spring and damping forces are the same either way round
+    std::vector<SpringContent> springContents(springsSize);
+    for (unsigned i = 0; i < springsSize; i++)
+    {
+        const int a = newIndex[springs[i]->m1->index];
+        const int b = newIndex[springs[i]->m2->index];
+
+        springContents[i].material = springs[i]->material;
+        springContents[i].restLengthScale = springs[i]->restLengthScale;
+        springContents[i].mass1Index = std::min(a, b);
+        springContents[i].mass2Index = std::max(a, b);
+    }
+
+    std::stable_sort(springContents.begin(), springContents.end(),
+        [](const SpringContent& lhs, const SpringContent& rhs)
+        {
+            if (lhs.mass1Index != rhs.mass1Index)
+                return lhs.mass1Index < rhs.mass1Index;
+            return lhs.mass2Index < rhs.mass2Index;
+        });
+
+    std::vector<PointMass> massContents;
+    massContents.reserve(massesSize);
+    for (unsigned i = 0; i < massesSize; i++)
+        massContents.push_back(*masses[order[i]]);
+
+    for (unsigned i = 0; i < massesSize; i++)
+    {
+        *masses[i] = massContents[i];
+        masses[i]->springs.clear();
+    }
+
+    for (unsigned i = 0; i < springsSize; i++)
+    {
+        const SpringContent& content = springContents[i];
+        PointMass* mass1 = masses[content.mass1Index];
+        PointMass* mass2 = masses[content.mass2Index];
+
+        springs[i]->Reset(content.material, content.restLengthScale, mass1, mass2);
+        mass1->springs.push_back(springs[i]);
+        mass2->springs.push_back(springs[i]);
+    }
+
+    Initializing();
+
+    return newIndex;
+}
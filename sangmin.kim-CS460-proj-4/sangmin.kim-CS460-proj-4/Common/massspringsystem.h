@@ -6,9 +6,14 @@
 #pragma once
 
 #include <vector>
+#include "ClothMaterial.h"
 #include "Pointmass.h"
+#include "SleepTiles.h"
+#include "SpaceFillingCurve.h"
+#include "StrainLimiter.h"
 #include "Spring.h"
 
+class JobSystem;
 class SimpleBox;
 class Shader;
 
@@ -17,28 +22,70 @@ class MassSpringSystem
 public:
     MassSpringSystem(Shader* dotShader_, Shader* lineShader_);
     ~MassSpringSystem();
-    PointMass* AddMass(float mass, float x, float y, float z);
-    void AddSpring(float springConstant, float restLength,
-                      int mass1Index, int mass2Index, float dampingConstant);
+    unsigned AddMaterial(const ClothMaterial& material);
+    PointMass* AddMass(unsigned material, float x, float y, float z);
+    void AddSpring(unsigned material, float restLengthScale,
+                      int mass1Index, int mass2Index);
 
 
     void update(float dt, SimpleBox* box);
+    //after update : pulls springs back within (1 + maxStretch) of their length at Initializing
+    void LimitStrain(float dt, float maxStretch, int iterations, JobSystem* jobSystem);
     void draw(glm::mat4 projViewMat);
     void Initializing();
+    //keeps masses, springs and GPU buffers for the next AddMass / AddSpring / Initializing
+    void Reset();
+    /*
+     * After Initializing : renumbers masses along the curve and sorts springs by first endpoint.
+     * Contents move between the existing objects, so memory order follows the curve too.
+     * Returns newIndex[oldIndex], PointMass* or indices taken before must be remapped with it.
+     */
+    std::vector<int> ReorderMasses(SpaceFillingCurve::Curve curve);
+    //moves a mass from outside (anchors), wakes its tile and returns true when the position changed
+    bool SetMassPosition(int index, glm::vec3 position);
+    //for rollback of a diverging step : masses of the given tiles and every tile's sleep state
+    void SaveState(const std::vector<unsigned>& tiles, ClothSnapshot& snapshot) const;
+    void RestoreState(const std::vector<unsigned>& tiles, const ClothSnapshot& snapshot, bool keepVelocities);
+    //one entry per spring, in springs order
+    void GetSpringLengths(std::vector<float>& lengths, std::vector<float>& restLengths) const;
+    //indices of springs with an end in one of the tiles, may repeat
+    void GetTileSprings(const std::vector<unsigned>& tiles, std::vector<unsigned>& springIndices) const;
+    //rewrites lengths[i] of only those springs, lengths keeps its size
+    void GetSpringLengths(const std::vector<unsigned>& springIndices, std::vector<float>& lengths) const;
+    //largest sum of spring (0.5 * k) and damping constants on one mass, divided by its mass
+    void GetStiffnessRatios(float& stiffnessToMass, float& dampingToMass) const;
 
     std::vector<PointMass*> masses;
     std::vector<glm::vec3> massesPositions;
+    //shared by index, editable between steps, kept over Reset
+    std::vector<ClothMaterial> materials;
+    //tiles are runs of massesPerTile consecutive masses, compact after ReorderMasses
+    SleepTiles sleepTiles;
+    static const unsigned massesPerTile = 64;
 
 private:
     std::vector<glm::vec3> springPositions;
     
     std::vector<Spring*> springs;
+    //springs with an end in the tile, their line positions are rewritten when it is stepped
+    std::vector<std::vector<unsigned>> tileSprings;
+    //massesPositions / springPositions changed since the last draw
+    bool positionsDirty = true;
+
+    //springs as constraints (greedy coloured), and mass state copied into arrays for it
+    StrainLimiter strainLimiter;
+    std::vector<float> limitPx, limitPy, limitPz;
+    std::vector<float> limitVx, limitVy, limitVz;
+    std::vector<float> inverseMasses;
+    //objects of previous simulation, reused before new ones are allocated
+    std::vector<PointMass*> spareMasses;
+    std::vector<Spring*> spareSprings;
     Shader* dotShader;
 	Shader* lineShader;
 
-    unsigned dotShaderVao;
-    Buffer* dotPosBuffer;
+    unsigned dotShaderVao = 0;
+    Buffer* dotPosBuffer = nullptr;
 
-    unsigned springShaderVao;
-    Buffer* springPosBuffer;
+    unsigned springShaderVao = 0;
+    Buffer* springPosBuffer = nullptr;
 };
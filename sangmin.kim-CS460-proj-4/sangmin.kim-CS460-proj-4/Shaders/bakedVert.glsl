@@ -0,0 +1,121 @@
+#version 430
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in uvec4 boneIds0;
+layout(location = 4) in vec4 boneWeights0;
+layout(location = 5) in uvec4 boneIds1;
+layout(location = 6) in vec4 boneWeights1;
+
+out vec2 TexCoord0;
+out vec3 Normal0;
+out vec3 LocalPos0;
+
+struct BakedClip
+{
+    uint firstMatrix;
+    uint frameCount;
+    float frameRate;
+    float duration;
+};
+
+struct BakedInstance
+{
+    mat4 world;
+    vec4 playback;
+};
+
+uniform mat4 gVP;
+uniform float time;
+uniform int boneCount;
+uniform int bakedFormat;
+uniform int blendFrames;
+uniform int influenceCount;
+
+layout(std430, binding = 5) readonly buffer bakedFloatPalette
+{
+    vec4 floatRows[];
+};
+layout(std430, binding = 6) readonly buffer bakedHalfPalette
+{
+    uvec2 halfRows[];
+};
+layout(std430, binding = 7) readonly buffer bakedClips
+{
+    BakedClip clips[];
+};
+layout(std430, binding = 8) readonly buffer bakedInstances
+{
+    BakedInstance instances[];
+};
+
+vec4 FetchRow(uint rowIndex)
+{
+    if (bakedFormat == 0)
+        return floatRows[rowIndex];
+
+    uvec2 packedRow = halfRows[rowIndex];
+    return vec4(unpackHalf2x16(packedRow.x), unpackHalf2x16(packedRow.y));
+}
+
+mat4 FetchMatrix(uint matrixIndex)
+{
+    vec4 row0 = FetchRow(matrixIndex * 3u);
+    vec4 row1 = FetchRow(matrixIndex * 3u + 1u);
+    vec4 row2 = FetchRow(matrixIndex * 3u + 2u);
+
+    return transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat4 SkinGroup(uvec4 ids, vec4 weights, uint frame0, uint frame1, float factor)
+{
+    mat4 result = mat4(0.0);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (weights[i] == 0.0)
+            continue;
+
+        mat4 bone = FetchMatrix(frame0 + ids[i]);
+        if (blendFrames != 0)
+            bone = mix(bone, FetchMatrix(frame1 + ids[i]), factor);
+
+        result += bone * weights[i];
+    }
+
+    return result;
+}
+
+void main()
+{
+    BakedInstance instance = instances[gl_InstanceID];
+    BakedClip clip = clips[int(instance.playback.x)];
+
+    float clipTime = max(time * instance.playback.z + instance.playback.y, 0.0);
+    if (clip.duration > 0.0)
+        clipTime = mod(clipTime, clip.duration);
+
+    float frameTime = clipTime * clip.frameRate;
+    uint frame = min(uint(floor(frameTime)), clip.frameCount - 1u);
+    uint nextFrame = (frame + 1u) % clip.frameCount;
+
+    //last frame to frame 0 spans only the rest of the clip, not a whole frame
+    float frameLength = nextFrame == 0u ? clip.duration * clip.frameRate - float(frame) : 1.0;
+    float factor = frameLength > 0.0 ? clamp((frameTime - float(frame)) / frameLength, 0.0, 1.0) : 0.0;
+
+    uint frame0 = clip.firstMatrix + frame * uint(boneCount);
+    uint frame1 = clip.firstMatrix + nextFrame * uint(boneCount);
+
+    mat4 boneTransform = SkinGroup(boneIds0, boneWeights0, frame0, frame1, factor);
+
+    if (influenceCount > 4)
+        boneTransform += SkinGroup(boneIds1, boneWeights1, frame0, frame1, factor);
+
+    vec4 posL = boneTransform * vec4(position, 1.0);
+    gl_Position = gVP * instance.world * posL;
+
+    TexCoord0 = texCoord;
+    Normal0 = normal;
+    LocalPos0 = position;
+}
@@ -3,6 +3,10 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
 layout(location = 2) in vec3 normal;
+layout(location = 3) in uvec4 boneIds0;
+layout(location = 4) in vec4 boneWeights0;
+layout(location = 5) in uvec4 boneIds1;
+layout(location = 6) in vec4 boneWeights1;
 
 out vec2 TexCoord0;
 out vec3 Normal0;
@@ -14,25 +18,10 @@ uniform mat4 gWVP;
 uniform mat4 gBones[MAX_BONES];
 uniform int transformIndex;
 uniform float timeTicks;
+uniform int influenceCount;
 
 mat4 Interpolation(mat4 currTransform, mat4 nextTransform, float timeTicksFloat);
-
-layout(std430, binding = 0) buffer boneDatas
-{
-    int bones[];
-};
-layout(std430, binding = 1) buffer weightDatas
-{
-    float weights[];
-};
-layout(std430, binding = 2) buffer indexStartDatas
-{
-    int indexStart[];
-};
-layout(std430, binding = 3) buffer indexEndDatas
-{
-    int indexEnd[];
-};
+mat4 SkinGroup(uvec4 ids, vec4 weights);
 
 //layout(std430, binding = 4) buffer transforms_
 //{
@@ -44,22 +33,22 @@ mat4 Interpolation(mat4 currTransform, mat4 nextTransform, float timeTicksFloat)
     return currTransform + (nextTransform * timeTicksFloat);
 }
 
+mat4 SkinGroup(uvec4 ids, vec4 weights)
+{
+    return gBones[int(ids.x) + transformIndex] * weights.x +
+        gBones[int(ids.y) + transformIndex] * weights.y +
+        gBones[int(ids.z) + transformIndex] * weights.z +
+        gBones[int(ids.w) + transformIndex] * weights.w;
+}
+
 
 
 void main()
 {
-    int startIndex = indexStart[gl_VertexID];
-    int endIndex = indexEnd[gl_VertexID];
-
-    mat4 boneTransform = gBones[bones[startIndex] + transformIndex] * weights[startIndex];
-
-    for (int i = startIndex + 1; i < endIndex; ++i)
-    {
-        int boneId = bones[i];
-        float weight = weights[i];
+    mat4 boneTransform = SkinGroup(boneIds0, boneWeights0);
 
-        boneTransform += gBones[boneId + transformIndex] * weight;
-    }
+    if (influenceCount > 4)
+        boneTransform += SkinGroup(boneIds1, boneWeights1);
 
     vec4 posL = boneTransform * vec4(position, 1.0);
     gl_Position = gWVP * posL;